@@ -0,0 +1,213 @@
+#include "entities/Product.h"
+#include "entities/ProductRepository.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Times building, sorting and scanning a million products held by
+// ProductRepository<Product>. "before" is the repository as it was before it
+// was constrained by ProductLike, kept below as it was written, with a
+// dynamic_cast per element and two per sort comparison. "after" is
+// ProductRepository<Product> today, which also keeps its sorted indexes up
+// to date on every add. Both run over the same Product objects. Since
+// T = Product, the casts on the "before" side are to the element's own type.
+
+// Product ids are assigned by storage; this stands in for it.
+class ProductRepositoryBenchmark {
+public:
+  static std::shared_ptr<Product> makeProduct(int id, const std::string &name,
+                                              const std::string &category,
+                                              int quantity, double unitPrice) {
+    auto product =
+        std::make_shared<Product>(name, category, quantity, unitPrice);
+    product->setId(id);
+    return product;
+  }
+};
+
+namespace {
+
+template <typename T> class LegacyProductRepository {
+  std::vector<std::shared_ptr<T>> products;
+  std::map<int, std::shared_ptr<T>> productMap;
+
+public:
+  void add(std::shared_ptr<T> product) {
+    if (auto *p = dynamic_cast<Product *>(product.get())) {
+      products.push_back(product);
+      productMap[p->getId()] = product;
+    }
+  }
+
+  template <typename Predicate>
+  std::vector<std::shared_ptr<T>> filter(Predicate pred) const {
+    std::vector<std::shared_ptr<T>> result;
+    std::copy_if(products.begin(), products.end(), std::back_inserter(result),
+                 pred);
+    return result;
+  }
+
+  void sortByName() {
+    std::sort(products.begin(), products.end(),
+              [](const std::shared_ptr<T> &a, const std::shared_ptr<T> &b) {
+                if (auto *pa = dynamic_cast<Product *>(a.get())) {
+                  if (auto *pb = dynamic_cast<Product *>(b.get())) {
+                    return pa->getName() < pb->getName();
+                  }
+                }
+                return false;
+              });
+  }
+
+  void sortByPrice() {
+    std::sort(products.begin(), products.end(),
+              [](const std::shared_ptr<T> &a, const std::shared_ptr<T> &b) {
+                if (auto *pa = dynamic_cast<Product *>(a.get())) {
+                  if (auto *pb = dynamic_cast<Product *>(b.get())) {
+                    return pa->getUnitPrice() < pb->getUnitPrice();
+                  }
+                }
+                return false;
+              });
+  }
+
+  std::vector<std::shared_ptr<T>>
+  searchByCategory(const std::string &category) const {
+    return filter([&category](const std::shared_ptr<T> &p) {
+      if (auto *product = dynamic_cast<Product *>(p.get())) {
+        return product->getCategory() == category;
+      }
+      return false;
+    });
+  }
+
+  void clear() {
+    products.clear();
+    productMap.clear();
+  }
+
+  double calculateTotalInventoryValue() const {
+    double total = 0.0;
+    for (const auto &product : products) {
+      if (auto *p = dynamic_cast<Product *>(product.get())) {
+        total += p->calculateTotalValue();
+      }
+    }
+    return total;
+  }
+};
+
+const char *const CATEGORIES[] = {"Food", "Electronics", "Clothing", "Books",
+                                  "Other"};
+
+template <typename Work> double millisecondsFor(Work work) {
+  double best = 0.0;
+  for (int run = 0; run < 3; ++run) {
+    auto start = std::chrono::steady_clock::now();
+    work();
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (run == 0 || elapsed.count() < best) {
+      best = elapsed.count();
+    }
+  }
+  return best;
+}
+
+void report(const char *operation, double before, double after) {
+  std::printf("%-18s %10.1f %10.1f %9.2fx\n", operation, before, after,
+              before / after);
+}
+
+// Every build starts from the same shuffled products.
+template <typename Repository>
+void fill(Repository &repository,
+          const std::vector<std::shared_ptr<Product>> &shuffled) {
+  repository.clear();
+  for (const auto &product : shuffled) {
+    repository.add(product);
+  }
+}
+
+// Only the sort is timed; each run refills first so that it never starts
+// from an already sorted listing.
+template <typename Repository, typename Sort>
+double sortMilliseconds(Repository &repository,
+                        const std::vector<std::shared_ptr<Product>> &shuffled,
+                        Sort sort) {
+  double best = 0.0;
+  for (int run = 0; run < 3; ++run) {
+    fill(repository, shuffled);
+    auto start = std::chrono::steady_clock::now();
+    sort(repository);
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (run == 0 || elapsed.count() < best) {
+      best = elapsed.count();
+    }
+  }
+  return best;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const int count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> quantities(0, 500);
+  std::uniform_real_distribution<double> prices(0.5, 2000.0);
+
+  std::vector<std::shared_ptr<Product>> shuffled;
+  shuffled.reserve(count);
+  for (int id = 1; id <= count; ++id) {
+    shuffled.push_back(ProductRepositoryBenchmark::makeProduct(
+        id, "Product " + std::to_string(random()), CATEGORIES[id % 5],
+        quantities(random), prices(random)));
+  }
+  std::shuffle(shuffled.begin(), shuffled.end(), random);
+
+  LegacyProductRepository<Product> before;
+  ProductRepository<Product> after;
+
+  std::printf("%d products, best of 3 runs, milliseconds\n", count);
+  std::printf("%-18s %10s %10s %10s\n", "operation", "before", "after",
+              "speedup");
+
+  report("build", millisecondsFor([&] { fill(before, shuffled); }),
+         millisecondsFor([&] { fill(after, shuffled); }));
+
+  report("sort by name",
+         sortMilliseconds(before, shuffled,
+                          [](auto &repository) { repository.sortByName(); }),
+         sortMilliseconds(after, shuffled,
+                          [](auto &repository) { repository.sortByName(); }));
+  report("sort by price",
+         sortMilliseconds(before, shuffled,
+                          [](auto &repository) { repository.sortByPrice(); }),
+         sortMilliseconds(after, shuffled,
+                          [](auto &repository) { repository.sortByPrice(); }));
+
+  volatile double sink = 0.0;
+  report("total value", millisecondsFor([&] {
+           sink = before.calculateTotalInventoryValue();
+         }),
+         millisecondsFor(
+             [&] { sink = after.calculateTotalInventoryValue(); }));
+
+  volatile size_t found = 0;
+  report("category search", millisecondsFor([&] {
+           found = before.searchByCategory("Books").size();
+         }),
+         millisecondsFor(
+             [&] { found = after.searchByCategory("Books").size(); }));
+
+  return 0;
+}
@@ -0,0 +1,149 @@
+#include "managers/Crc32c.h"
+#include "managers/RecordLog.h"
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Times loading a log of product-sized records with and without checking
+// them. "unchecked" walks the same frames through the same stream and
+// copies the same payloads, but trusts them; "checked" is RecordLog::scan,
+// which also verifies each frame's CRC-32C. Validation is budgeted at under
+// 5% of the load.
+
+namespace {
+
+const quint32 BENCH_LOG_MAGIC = 0x42454E43;
+const quint32 FRAME_MARKER = 0x5246524D;
+const int FRAME_HEAD_SIZE = 9;
+const char *const CATEGORIES[] = {"Food", "Electronics", "Clothing", "Books",
+                                  "Other"};
+
+template <typename Work> double millisecondsFor(Work work) {
+  double best = 0.0;
+  for (int run = 0; run < 3; ++run) {
+    auto start = std::chrono::steady_clock::now();
+    work();
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (run == 0 || elapsed.count() < best) {
+      best = elapsed.count();
+    }
+  }
+  return best;
+}
+
+// Laid out like an encoded product: id, name, category, quantity, price.
+QByteArray productPayload(int id, std::mt19937 &random) {
+  QByteArray payload;
+  QDataStream out(&payload, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_6_0);
+  out << static_cast<qint32>(id)
+      << QString("Product %1").arg(random() % 100000)
+      << QString(CATEGORIES[id % 5])
+      << static_cast<qint32>(random() % 500) << (random() % 200000) / 100.0;
+  return payload;
+}
+
+bool writeLog(const QString &path, int count) {
+  RecordLog log(path, BENCH_LOG_MAGIC);
+  if (!log.create()) {
+    return false;
+  }
+
+  std::mt19937 random(42);
+  std::vector<RecordLog::Record> batch;
+  for (int id = 1; id <= count; ++id) {
+    RecordLog::Record record;
+    record.key = id;
+    record.payload = productPayload(id, random);
+    batch.push_back(record);
+    if (batch.size() == 10000 || id == count) {
+      if (!log.append(batch)) {
+        return false;
+      }
+      batch.clear();
+    }
+  }
+  return true;
+}
+
+// The frame walk RecordLog::scan does, minus the checksum.
+size_t readUnchecked(const QString &path) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return 0;
+  }
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_6_0);
+  RecordLog::readVersion(in);
+
+  size_t records = 0;
+  QByteArray payload;
+  char head[FRAME_HEAD_SIZE];
+  while (!in.atEnd()) {
+    quint32 marker = 0;
+    quint32 crc = 0;
+    in >> marker >> crc;
+    if (in.status() != QDataStream::Ok || marker != FRAME_MARKER ||
+        in.readRawData(head, sizeof(head)) != FRAME_HEAD_SIZE) {
+      break;
+    }
+    quint32 length = qFromBigEndian<quint32>(head);
+    if (length > file.bytesAvailable()) {
+      break;
+    }
+    payload.resize(length);
+    if (in.readRawData(payload.data(), length) != static_cast<int>(length)) {
+      break;
+    }
+    records++;
+  }
+  return records;
+}
+
+size_t readChecked(const QString &path) {
+  size_t records = 0;
+  RecordLog(path, BENCH_LOG_MAGIC).scan([&records](const RecordLog::Record &) {
+    records++;
+  });
+  return records;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const int count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+  QTemporaryDir dir;
+  QString path = dir.filePath("bench.log");
+  if (!dir.isValid() || !writeLog(path, count)) {
+    std::fprintf(stderr, "Cannot write the benchmark log\n");
+    return 1;
+  }
+
+  // Warm the page cache so both runs read from memory.
+  readUnchecked(path);
+
+  volatile size_t sink = 0;
+  double unchecked = millisecondsFor([&] { sink = readUnchecked(path); });
+  double checked = millisecondsFor([&] { sink = readChecked(path); });
+  double overhead = (checked - unchecked) / unchecked * 100.0;
+
+  std::printf("%d records, %lld bytes, best of 3 runs, milliseconds\n", count,
+              static_cast<long long>(QFile(path).size()));
+  std::printf("CRC-32C in hardware: %s\n",
+              Crc32c::isHardwareAccelerated() ? "yes" : "no");
+  std::printf("%-12s %10.1f\n", "unchecked", unchecked);
+  std::printf("%-12s %10.1f\n", "checked", checked);
+  std::printf("%-12s %9.1f%% (budget 5%%)\n", "overhead", overhead);
+  return 0;
+}
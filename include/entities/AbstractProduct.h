@@ -18,8 +18,8 @@ public:
 
     virtual std::string getProductType() const = 0;
 
-    std::string getName() const { return name; }
-    std::string getCategory() const { return category; }
+    const std::string& getName() const { return name; }
+    const std::string& getCategory() const { return category; }
     int getQuantity() const { return quantity; }
     double getUnitPrice() const { return unitPrice; }
 
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "entities/Product.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Products held as parallel columns, one slot each, so totals and filters are
+// linear scans over plain arrays. Names and categories are interned. A removed
+// product leaves a dead slot that matches nothing and adds nothing; dead slots
+// are compacted away once they outnumber live ones, keeping insertion order.
+// Each category also keeps the list of its slots and running totals.
+class DenseProductRepository {
+public:
+    using StringRef = std::uint32_t;
+
+    struct CategoryTotals {
+        int productCount = 0;
+        int totalQuantity = 0;
+        double totalValue = 0.0;
+    };
+
+private:
+    static constexpr StringRef DEAD_REF = UINT32_MAX;
+    static constexpr std::uint32_t FREE_BUCKET = UINT32_MAX;
+
+    struct Bucket {
+        int id;
+        std::uint32_t slot;
+    };
+
+    std::vector<int> ids;
+    std::vector<int> quantities;
+    std::vector<double> prices;
+    std::vector<StringRef> nameRefs;
+    std::vector<StringRef> categoryRefs;
+    size_t deadSlots = 0;
+
+    struct StringPool {
+        std::vector<std::string> values;
+        std::unordered_map<std::string, StringRef> refs;
+
+        StringRef intern(const std::string& value);
+        StringRef lookup(const std::string& value) const;
+    };
+
+    StringPool names;
+    StringPool categories;
+
+    // Indexed by category ref. A slot's place in its category's list is kept
+    // in postingPositions so it can be taken out in O(1).
+    std::vector<std::vector<std::uint32_t>> categorySlots;
+    std::vector<CategoryTotals> categoryTotalsByRef;
+    std::vector<std::uint32_t> postingPositions;
+
+    // Open addressing with linear probing and backward-shift deletion.
+    std::vector<Bucket> buckets;
+    unsigned hashShift = 32;
+
+    void fileSlot(std::uint32_t slot);
+    void unfileSlot(std::uint32_t slot);
+
+    size_t bucketOf(int id) const;
+    std::uint32_t slotOf(int id) const;
+    void indexInsert(int id, std::uint32_t slot);
+    void indexErase(int id);
+    void rehash(size_t capacity);
+    void compact();
+
+public:
+    void upsert(const Product& product);
+    bool remove(int id);
+    bool contains(int id) const { return slotOf(id) != FREE_BUCKET; }
+    void clear();
+
+    size_t size() const { return ids.size() - deadSlots; }
+    bool empty() const { return size() == 0; }
+
+    double totalValue() const;
+    int totalQuantity() const;
+
+    // Ids in insertion order. The category lookup costs O(k log k) for k
+    // matches, independent of the repository size.
+    std::vector<int> idsInCategory(const std::string& category) const;
+    std::vector<int> idsWithNameContaining(const std::string& text) const;
+
+    CategoryTotals categoryTotals(const std::string& category) const;
+    // Non-empty categories by name.
+    std::vector<std::pair<std::string, CategoryTotals>> categorySummary() const;
+};
@@ -6,12 +6,14 @@
 #include <vector>
 
 
-class DatabaseManager;
+class FileStorageBackend;
+class SqliteStorageBackend;
 
 enum class OrderType { RETAIL, WHOLESALE };
 
 class Order {
-  friend class DatabaseManager;
+  friend class FileStorageBackend;
+  friend class SqliteStorageBackend;
 
 private:
   int id;
@@ -24,8 +26,6 @@ private:
   double totalAmount;
   double totalDiscount;
 
-  static int nextId;
-
 public:
   Order();
   Order(const QString &company, const QString &contact, const QString &phoneNum,
@@ -58,6 +58,4 @@ public:
   QString getOrderTypeString() const {
     return orderType == OrderType::RETAIL ? "Retail" : "Wholesale";
   }
-
-  static void setNextId(int maxId);
 };
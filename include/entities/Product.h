@@ -7,15 +7,17 @@
 
 class ProductDialog;
 class FileManager;
+class ProductRepositoryBenchmark;
 
 class Product : public AbstractProduct {
     friend class ProductDialog;
     friend class FileManager;
-    friend class DatabaseManager;
+    friend class FileStorageBackend;
+    friend class SqliteStorageBackend;
+    friend class ProductRepositoryBenchmark;
     
 private:
     int id;
-    static int nextId;
     
     void setId(int newId) { id = newId; }
 
@@ -26,12 +28,10 @@ public:
     Product(const Product& other);
     Product& operator=(const Product& other);
 
-    double calculateTotalValue() const override;
+    double calculateTotalValue() const final;
     std::string getProductType() const override;
 
     int getId() const { return id; }
-    
-    static void setNextId(int maxId);
 
     Product operator+(int quantity) const;
     Product& operator+=(int quantity);
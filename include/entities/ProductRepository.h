@@ -2,32 +2,103 @@
 
 #include "entities/Product.h"
 #include <vector>
-#include <map>
+#include <set>
+#include <unordered_map>
 #include <algorithm>
+#include <climits>
+#include <concepts>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
 
+// What the repository needs from its element type. Checked at compile time,
+// so every accessor call is resolved statically.
 template<typename T>
+concept ProductLike = requires(const T& product) {
+    { product.getId() } -> std::convertible_to<int>;
+    { product.getName() } -> std::convertible_to<const std::string&>;
+    { product.getCategory() } -> std::convertible_to<const std::string&>;
+    { product.getQuantity() } -> std::convertible_to<int>;
+    { product.getUnitPrice() } -> std::convertible_to<double>;
+    { product.calculateTotalValue() } -> std::convertible_to<double>;
+};
+
+template<ProductLike T>
 class ProductRepository {
+public:
+    enum class SortKey { Name, Price, Quantity, Category };
+
 private:
+    // Ordered (key, id) sets kept in step with every add, replace and remove.
+    template<typename Key>
+    using SortedIndex = std::set<std::pair<Key, int>>;
+
+    SortedIndex<std::string> byName;
+    SortedIndex<double> byPrice;
+    SortedIndex<int> byQuantity;
+    SortedIndex<std::string> byCategory;
+
+    struct Entry {
+        size_t index;
+        size_t position;
+        typename SortedIndex<std::string>::iterator name;
+        typename SortedIndex<double>::iterator price;
+        typename SortedIndex<int>::iterator quantity;
+        typename SortedIndex<std::string>::iterator category;
+    };
+
+    // Storage is packed: remove() moves the last product into the hole.
+    // The order products are listed in lives separately in displayOrder,
+    // where a removed product leaves a null that is compacted away lazily.
     std::vector<std::shared_ptr<T>> products;
-    std::map<int, std::shared_ptr<T>> productMap;
+    std::unordered_map<int, Entry> entries;
+    std::vector<std::shared_ptr<T>> displayOrder;
+    size_t displayHoles = 0;
+
+    void compactDisplayOrder();
+    void setDisplayOrder(std::vector<std::shared_ptr<T>> order);
+    void indexKeys(Entry& entry, const T& product);
+    void unindexKeys(const Entry& entry);
+
+    template<typename Iterator>
+    std::vector<std::shared_ptr<T>> collect(Iterator first, Iterator last,
+                                            size_t limit) const;
+    template<typename Index>
+    std::vector<std::shared_ptr<T>> collectOrdered(const Index& index, size_t limit,
+                                                   bool descending) const;
 
 public:
     void add(std::shared_ptr<T> product);
+    // Swaps in a new version of a product at the same place in the display
+    // order, under its new id if that changed. Fails if id is not stored or
+    // the new id already belongs to another product.
+    bool replace(int id, std::shared_ptr<T> product);
     void remove(int id);
+    // Call after changing a stored product in place. The find* results share
+    // the stored products, and until then the sorted indexes are out of order.
+    void reindex(int id);
     std::shared_ptr<T> findById(int id) const;
-    std::vector<std::shared_ptr<T>> findAll() const { return products; }
+    std::vector<std::shared_ptr<T>> findAll() const;
+    // The stored products among ids, in display order; unknown ids are skipped.
+    std::vector<std::shared_ptr<T>> findByIds(const std::vector<int>& ids) const;
     
     template<typename Predicate>
     std::vector<std::shared_ptr<T>> filter(Predicate pred) const {
         std::vector<std::shared_ptr<T>> result;
-        std::copy_if(products.begin(), products.end(), 
-                    std::back_inserter(result), pred);
+        std::copy_if(displayOrder.begin(), displayOrder.end(),
+                    std::back_inserter(result),
+                    [&pred](const std::shared_ptr<T>& p) { return p && pred(p); });
         return result;
     }
 
+    // Served from the sorted indexes in O(log n + k); bounds are inclusive.
+    std::vector<std::shared_ptr<T>> orderedBy(SortKey key, size_t limit = SIZE_MAX,
+                                              bool descending = false) const;
+    std::vector<std::shared_ptr<T>> findByPriceRange(double minPrice, double maxPrice) const;
+    std::vector<std::shared_ptr<T>> findByQuantityRange(int minQuantity, int maxQuantity) const;
+
+    // Reorder the listing only; storage is left as it is.
     void sortByName();
     void sortByPrice();
     void sortByQuantity();
@@ -36,6 +107,7 @@ public:
     std::vector<std::shared_ptr<T>> searchByName(const std::string& name) const;
     std::vector<std::shared_ptr<T>> searchByCategory(const std::string& category) const;
 
+    // Iteration follows storage, not display, order.
     using iterator = typename std::vector<std::shared_ptr<T>>::iterator;
     using const_iterator = typename std::vector<std::shared_ptr<T>>::const_iterator;
     
@@ -54,4 +126,3 @@ public:
 };
 
 #include "ProductRepository.tpp"
-
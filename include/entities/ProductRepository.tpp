@@ -3,122 +3,270 @@
 #include "entities/ProductRepository.h"
 #include <algorithm>
 
-template<typename T>
+template<ProductLike T>
 void ProductRepository<T>::add(std::shared_ptr<T> product) {
-    if (auto* p = dynamic_cast<Product*>(product.get())) {
-        products.push_back(product);
-        productMap[p->getId()] = product;
+    int id = product->getId();
+    if (replace(id, product)) {
+        return;
     }
+    Entry entry{products.size(), displayOrder.size(), {}, {}, {}, {}};
+    indexKeys(entry, *product);
+    entries[id] = entry;
+    products.push_back(product);
+    displayOrder.push_back(std::move(product));
 }
 
-template<typename T>
+template<ProductLike T>
+bool ProductRepository<T>::replace(int id, std::shared_ptr<T> product) {
+    auto it = entries.find(id);
+    if (it == entries.end()) {
+        return false;
+    }
+    int newId = product->getId();
+    if (newId != id && entries.find(newId) != entries.end()) {
+        return false;
+    }
+
+    Entry entry = it->second;
+    unindexKeys(entry);
+    indexKeys(entry, *product);
+    products[entry.index] = product;
+    displayOrder[entry.position] = std::move(product);
+    if (newId != id) {
+        entries.erase(it);
+        entries[newId] = entry;
+    } else {
+        it->second = entry;
+    }
+    return true;
+}
+
+template<ProductLike T>
 void ProductRepository<T>::remove(int id) {
-    auto it = std::remove_if(products.begin(), products.end(),
-        [id](const std::shared_ptr<T>& p) {
-            if (auto* product = dynamic_cast<Product*>(p.get())) {
-                return product->getId() == id;
-            }
-            return false;
-        });
-    products.erase(it, products.end());
-    productMap.erase(id);
-}
-
-template<typename T>
+    auto it = entries.find(id);
+    if (it == entries.end()) {
+        return;
+    }
+    Entry entry = it->second;
+    entries.erase(it);
+    unindexKeys(entry);
+
+    if (entry.index + 1 != products.size()) {
+        products[entry.index] = std::move(products.back());
+        entries[products[entry.index]->getId()].index = entry.index;
+    }
+    products.pop_back();
+
+    displayOrder[entry.position] = nullptr;
+    displayHoles++;
+    if (displayHoles > products.size()) {
+        compactDisplayOrder();
+    }
+}
+
+template<ProductLike T>
+void ProductRepository<T>::compactDisplayOrder() {
+    size_t position = 0;
+    for (size_t i = 0; i < displayOrder.size(); ++i) {
+        if (!displayOrder[i]) {
+            continue;
+        }
+        if (i != position) {
+            displayOrder[position] = std::move(displayOrder[i]);
+        }
+        entries[displayOrder[position]->getId()].position = position;
+        position++;
+    }
+    displayOrder.resize(position);
+    displayHoles = 0;
+}
+
+template<ProductLike T>
+void ProductRepository<T>::setDisplayOrder(std::vector<std::shared_ptr<T>> order) {
+    displayOrder = std::move(order);
+    displayHoles = 0;
+    for (size_t position = 0; position < displayOrder.size(); ++position) {
+        entries[displayOrder[position]->getId()].position = position;
+    }
+}
+
+template<ProductLike T>
+void ProductRepository<T>::indexKeys(Entry& entry, const T& product) {
+    int id = product.getId();
+    entry.name = byName.emplace(product.getName(), id).first;
+    entry.price = byPrice.emplace(product.getUnitPrice(), id).first;
+    entry.quantity = byQuantity.emplace(product.getQuantity(), id).first;
+    entry.category = byCategory.emplace(product.getCategory(), id).first;
+}
+
+template<ProductLike T>
+void ProductRepository<T>::unindexKeys(const Entry& entry) {
+    byName.erase(entry.name);
+    byPrice.erase(entry.price);
+    byQuantity.erase(entry.quantity);
+    byCategory.erase(entry.category);
+}
+
+template<ProductLike T>
+void ProductRepository<T>::reindex(int id) {
+    auto it = entries.find(id);
+    if (it == entries.end()) {
+        return;
+    }
+    unindexKeys(it->second);
+    indexKeys(it->second, *products[it->second.index]);
+}
+
+template<ProductLike T>
+template<typename Iterator>
+std::vector<std::shared_ptr<T>> ProductRepository<T>::collect(Iterator first, Iterator last,
+                                                              size_t limit) const {
+    std::vector<std::shared_ptr<T>> result;
+    for (; first != last && result.size() < limit; ++first) {
+        result.push_back(products[entries.find(first->second)->second.index]);
+    }
+    return result;
+}
+
+template<ProductLike T>
+template<typename Index>
+std::vector<std::shared_ptr<T>> ProductRepository<T>::collectOrdered(const Index& index, size_t limit,
+                                                                     bool descending) const {
+    if (descending) {
+        return collect(index.rbegin(), index.rend(), limit);
+    }
+    return collect(index.begin(), index.end(), limit);
+}
+
+template<ProductLike T>
+std::vector<std::shared_ptr<T>> ProductRepository<T>::orderedBy(SortKey key, size_t limit,
+                                                                bool descending) const {
+    switch (key) {
+        case SortKey::Name:
+            return collectOrdered(byName, limit, descending);
+        case SortKey::Price:
+            return collectOrdered(byPrice, limit, descending);
+        case SortKey::Quantity:
+            return collectOrdered(byQuantity, limit, descending);
+        case SortKey::Category:
+            return collectOrdered(byCategory, limit, descending);
+    }
+    return {};
+}
+
+template<ProductLike T>
+std::vector<std::shared_ptr<T>> ProductRepository<T>::findByPriceRange(double minPrice,
+                                                                       double maxPrice) const {
+    if (minPrice > maxPrice) {
+        return {};
+    }
+    return collect(byPrice.lower_bound({minPrice, INT_MIN}),
+                   byPrice.upper_bound({maxPrice, INT_MAX}), SIZE_MAX);
+}
+
+template<ProductLike T>
+std::vector<std::shared_ptr<T>> ProductRepository<T>::findByQuantityRange(int minQuantity,
+                                                                          int maxQuantity) const {
+    if (minQuantity > maxQuantity) {
+        return {};
+    }
+    return collect(byQuantity.lower_bound({minQuantity, INT_MIN}),
+                   byQuantity.upper_bound({maxQuantity, INT_MAX}), SIZE_MAX);
+}
+
+template<ProductLike T>
 std::shared_ptr<T> ProductRepository<T>::findById(int id) const {
-    auto it = productMap.find(id);
-    if (it != productMap.end()) {
-        return it->second;
+    auto it = entries.find(id);
+    if (it != entries.end()) {
+        return products[it->second.index];
     }
     return nullptr;
 }
 
-template<typename T>
+template<ProductLike T>
+std::vector<std::shared_ptr<T>> ProductRepository<T>::findAll() const {
+    std::vector<std::shared_ptr<T>> result;
+    result.reserve(products.size());
+    for (const auto& product : displayOrder) {
+        if (product) {
+            result.push_back(product);
+        }
+    }
+    return result;
+}
+
+template<ProductLike T>
+std::vector<std::shared_ptr<T>> ProductRepository<T>::findByIds(const std::vector<int>& ids) const {
+    std::vector<std::pair<size_t, std::shared_ptr<T>>> found;
+    found.reserve(ids.size());
+    for (int id : ids) {
+        auto it = entries.find(id);
+        if (it != entries.end()) {
+            found.emplace_back(it->second.position, products[it->second.index]);
+        }
+    }
+    std::sort(found.begin(), found.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<std::shared_ptr<T>> result;
+    result.reserve(found.size());
+    for (auto& entry : found) {
+        result.push_back(std::move(entry.second));
+    }
+    return result;
+}
+
+template<ProductLike T>
 void ProductRepository<T>::sortByName() {
-    std::sort(products.begin(), products.end(),
-        [](const std::shared_ptr<T>& a, const std::shared_ptr<T>& b) {
-            if (auto* pa = dynamic_cast<Product*>(a.get())) {
-                if (auto* pb = dynamic_cast<Product*>(b.get())) {
-                    return pa->getName() < pb->getName();
-                }
-            }
-            return false;
-        });
-}
-
-template<typename T>
+    setDisplayOrder(orderedBy(SortKey::Name));
+}
+
+template<ProductLike T>
 void ProductRepository<T>::sortByPrice() {
-    std::sort(products.begin(), products.end(),
-        [](const std::shared_ptr<T>& a, const std::shared_ptr<T>& b) {
-            if (auto* pa = dynamic_cast<Product*>(a.get())) {
-                if (auto* pb = dynamic_cast<Product*>(b.get())) {
-                    return pa->getUnitPrice() < pb->getUnitPrice();
-                }
-            }
-            return false;
-        });
-}
-
-template<typename T>
+    setDisplayOrder(orderedBy(SortKey::Price));
+}
+
+template<ProductLike T>
 void ProductRepository<T>::sortByQuantity() {
-    std::sort(products.begin(), products.end(),
-        [](const std::shared_ptr<T>& a, const std::shared_ptr<T>& b) {
-            if (auto* pa = dynamic_cast<Product*>(a.get())) {
-                if (auto* pb = dynamic_cast<Product*>(b.get())) {
-                    return pa->getQuantity() < pb->getQuantity();
-                }
-            }
-            return false;
-        });
-}
-
-template<typename T>
+    setDisplayOrder(orderedBy(SortKey::Quantity));
+}
+
+template<ProductLike T>
 void ProductRepository<T>::sortByCategory() {
-    std::sort(products.begin(), products.end(),
-        [](const std::shared_ptr<T>& a, const std::shared_ptr<T>& b) {
-            if (auto* pa = dynamic_cast<Product*>(a.get())) {
-                if (auto* pb = dynamic_cast<Product*>(b.get())) {
-                    return pa->getCategory() < pb->getCategory();
-                }
-            }
-            return false;
-        });
-}
-
-template<typename T>
+    setDisplayOrder(orderedBy(SortKey::Category));
+}
+
+template<ProductLike T>
 std::vector<std::shared_ptr<T>> ProductRepository<T>::searchByName(const std::string& name) const {
     return filter([&name](const std::shared_ptr<T>& p) {
-        if (auto* product = dynamic_cast<Product*>(p.get())) {
-            return product->getName().find(name) != std::string::npos;
-        }
-        return false;
+        return p->getName().find(name) != std::string::npos;
     });
 }
 
-template<typename T>
+template<ProductLike T>
 std::vector<std::shared_ptr<T>> ProductRepository<T>::searchByCategory(const std::string& category) const {
     return filter([&category](const std::shared_ptr<T>& p) {
-        if (auto* product = dynamic_cast<Product*>(p.get())) {
-            return product->getCategory() == category;
-        }
-        return false;
+        return p->getCategory() == category;
     });
 }
 
-template<typename T>
+template<ProductLike T>
 void ProductRepository<T>::clear() {
     products.clear();
-    productMap.clear();
+    entries.clear();
+    byName.clear();
+    byPrice.clear();
+    byQuantity.clear();
+    byCategory.clear();
+    displayOrder.clear();
+    displayHoles = 0;
 }
 
-template<typename T>
+template<ProductLike T>
 double ProductRepository<T>::calculateTotalInventoryValue() const {
     double total = 0.0;
     for (const auto& product : products) {
-        if (auto* p = dynamic_cast<Product*>(product.get())) {
-            total += p->calculateTotalValue();
-        }
+        total += product->calculateTotalValue();
     }
     return total;
 }
-
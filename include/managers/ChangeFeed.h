@@ -0,0 +1,53 @@
+#ifndef CHANGEFEED_H
+#define CHANGEFEED_H
+
+#include <QMetaType>
+#include <QObject>
+#include <QtGlobal>
+#include <atomic>
+
+struct ChangeEvent {
+  enum class Kind {
+    ProductUpserted,
+    ProductRemoved,
+    StockChanged,
+    OrderAdded,
+    OrderUpdated,
+    OrderDeleted,
+    WriteOffAdded
+  };
+
+  quint64 sequence;
+  Kind kind;
+  int id;
+  int quantity;
+
+  ChangeEvent()
+      : sequence(0), kind(Kind::ProductUpserted), id(0), quantity(0) {}
+};
+
+Q_DECLARE_METATYPE(ChangeEvent)
+
+// Typed deltas published after each successful mutation. Sequence numbers
+// are consecutive per feed, so a subscriber that sees a gap knows it missed
+// something and must reload. Events published on another thread reach
+// subscribers in the GUI thread through queued connections; publishers on
+// different threads may interleave, so an event at or below the sequence a
+// subscriber last reloaded at is already reflected and can be skipped.
+class ChangeFeed : public QObject {
+  Q_OBJECT
+
+public:
+  explicit ChangeFeed(QObject *parent = nullptr);
+
+  quint64 publish(ChangeEvent::Kind kind, int id, int quantity = 0);
+  quint64 lastSequence() const { return sequence.load(); }
+
+signals:
+  void changed(const ChangeEvent &event);
+
+private:
+  std::atomic<quint64> sequence;
+};
+
+#endif
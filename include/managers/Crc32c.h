@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QtGlobal>
+#include <cstddef>
+
+// CRC-32C (Castagnoli). Uses the SSE4.2 or ARMv8 CRC instructions when the
+// CPU has them and a table-driven loop otherwise; all paths agree.
+class Crc32c {
+public:
+  static quint32 compute(const void *data, size_t size) {
+    return update(0, data, size);
+  }
+  // Continues a checksum, so update(compute(a), b) equals compute(a + b).
+  static quint32 update(quint32 crc, const void *data, size_t size);
+  static bool isHardwareAccelerated();
+};
@@ -3,32 +3,49 @@
 
 #include "entities/Order.h"
 #include "entities/Product.h"
-#include <QDataStream>
+#include "managers/ChangeFeed.h"
+#include "managers/FileSync.h"
+#include "managers/IdAllocator.h"
+#include "managers/StorageBackend.h"
+#include "managers/WriteQueue.h"
 #include <QDate>
-#include <QFile>
+#include <QFuture>
 #include <QString>
 #include <QStringList>
-#include <string>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
 #include <vector>
 
+// Safe to call from any thread. The manager lets reads of a store share it
+// and gives a write sole use of it. Reads never wait for queued writes.
+// A direct write waits only for queued writes to its own store. Calls on
+// different stores wait on each other in two cases: connection-wide
+// operations (connect, setBackend, flush and the like), and queued writes
+// that span stores, such as an order with its stock changes. Both backends
+// run reads of a store side by side too. A forEachOrder visitor runs with
+// the orders store held and must not call back into the manager.
+class DatabaseManager {
+public:
+  using Store = StorageBackend::Store;
+  enum class Backend { Files, Sqlite };
 
-struct WriteOffRecord {
-  int id;
-  int productId;
-  std::string productName;
-  int quantity;
-  double value;
-  QString reason;
+private:
+  static std::atomic<DatabaseManager *> instance;
+  static std::mutex instanceMutex;
 
-  WriteOffRecord() : id(0), productId(0), quantity(0), value(0.0) {}
-};
+  std::unique_ptr<StorageBackend> backend;
+  std::atomic<Backend> backendKind;
+  std::atomic<bool> residentCacheEnabled;
+  mutable std::map<Store, std::shared_mutex> storeMutexes;
 
-class DatabaseManager {
-private:
-  static DatabaseManager *instance;
-  QString dataFilePath;
-  QString writeOffFilePath;
-  QString ordersFilePath;
+  std::unique_ptr<WriteQueue> writeQueue;
+  ChangeFeed feed;
+  std::map<Store, std::unique_ptr<IdAllocator>> idAllocators;
 
   DatabaseManager();
   ~DatabaseManager();
@@ -37,52 +54,104 @@ public:
   static DatabaseManager *getInstance();
   static void destroyInstance();
 
+  static bool isBackendAvailable(Backend kind);
+  bool setBackend(Backend kind);
+  Backend currentBackend() const { return backendKind; }
+
+  ChangeFeed *changes() { return &feed; }
+
+  // Blocks until every queued write to store has landed. Reads do not wait
+  // on their own, so a caller that must see its queued writes calls this.
+  void awaitWrites(Store store);
+
   bool initializeDatabase();
   bool connect();
   void disconnect();
   bool isConnected() const;
+  // Corrupt records skipped and torn tails found since the store was last
+  // loaded in full.
+  LoadReport loadReport(Store store);
+
+  void setResidentCacheEnabled(bool enabled);
+  bool isResidentCacheEnabled() const { return residentCacheEnabled; }
+
+  void setDurability(Store store, Durability durability);
+  Durability durability(Store store) const;
+  bool flush();
+
+  // Fresh ids come from persisted per-type sequences, never from the data.
+  // The reserve variants return the first of count consecutive ids; all
+  // return -1 when the sequence cannot be written.
+  int nextProductId();
+  int nextOrderId();
+  int reserveProductIds(int count);
+  int reserveOrderIds(int count);
+
+  QFuture<bool> addProductAsync(const Product &product);
+  QFuture<bool> updateProductAsync(const Product &product);
+  QFuture<bool> deleteProductAsync(int id);
+  QFuture<bool> addOrderAsync(const Order &order);
+  // Saves an order and the product records its stock changes produced as a
+  // single queued write.
+  QFuture<bool> addOrderWithStockAsync(const Order &order,
+                                       std::vector<Product> products);
+  QFuture<bool> updateOrderAsync(const Order &order);
+  QFuture<bool> deleteOrderAsync(int id);
+  QFuture<bool> addWriteOffRecordAsync(int productId, int quantity,
+                                       double value, const QString &reason,
+                                       const QString &productName);
 
   bool addProduct(const Product &product);
   bool updateProduct(const Product &product);
   bool deleteProduct(int id);
+  std::vector<bool> addProducts(std::span<const Product> products);
+  std::vector<bool> updateProducts(std::span<const Product> products);
   Product getProduct(int id);
   std::vector<Product> getAllProducts();
 
   std::vector<Product> searchProductsByName(const QString &name);
   std::vector<Product> searchProductsByCategory(const QString &category);
+  double calculateTotalInventoryValue();
+  int getTotalProductQuantity();
 
   bool addWriteOffRecord(int productId, int quantity, double value,
                          const QString &reason);
   bool addWriteOffRecord(int productId, int quantity, double value,
                          const QString &reason, const QString &productName);
+  std::vector<bool> addWriteOffRecords(std::span<const WriteOffRecord> records);
   std::vector<QStringList> getWriteOffHistory();
 
   bool addOrder(const Order &order);
+  std::vector<bool> addOrders(std::span<const Order> orders);
   bool updateOrder(const Order &order);
   bool deleteOrder(int id);
   Order getOrder(int id);
   std::vector<Order> getAllOrders();
+  bool forEachOrder(const std::function<void(const Order &)> &visitor);
   std::vector<Order> getOrdersByCompany(const QString &companyName);
+  std::vector<Order> getOrdersByCompanyPrefix(const QString &prefix);
   std::vector<Order> getOrdersByType(OrderType type);
   std::vector<Order> getOrdersByDateRange(const QDate &startDate,
                                           const QDate &endDate);
+  std::vector<Order> getOrders(std::vector<int> ids);
+
+  std::vector<OrderHeader> getOrderHeaders();
+  std::vector<OrderHeader> getOrderHeadersByCompany(const QString &companyName);
+  std::vector<OrderHeader> getOrderHeadersByType(OrderType type);
+  std::vector<OrderHeader> getOrderHeadersByDateRange(const QDate &startDate,
+                                                      const QDate &endDate);
 
 private:
-  bool loadProducts(std::vector<Product> &products);
-  bool saveProducts(const std::vector<Product> &products);
-  bool loadWriteOffRecords(std::vector<WriteOffRecord> &records);
-  bool saveWriteOffRecords(const std::vector<WriteOffRecord> &records);
-  void writeProductToFile(QDataStream &stream, const Product &product);
-  bool readProductFromFile(QDataStream &stream, Product &product);
-  void writeWriteOffRecordToFile(QDataStream &stream,
-                                 const WriteOffRecord &record);
-  bool readWriteOffRecordFromFile(QDataStream &stream, WriteOffRecord &record);
-  bool loadOrders(std::vector<Order> &orders);
-  bool saveOrders(const std::vector<Order> &orders);
-  void writeOrderToFile(QDataStream &stream, const Order &order);
-  bool readOrderFromFile(QDataStream &stream, Order &order);
-  QString dateToString(const QDate &date);
-  QDate stringToDate(const QString &dateString);
+  void awaitWrites();
+  std::shared_lock<std::shared_mutex> lockForRead(Store store);
+  std::unique_lock<std::shared_mutex> lockForWrite(Store store);
+  std::scoped_lock<std::shared_mutex, std::shared_mutex, std::shared_mutex>
+  lockAllStores();
+  void publishProducts(std::span<const Product> products,
+                       const std::vector<bool> &results);
+  void seedIdAllocators();
+  int highestStoredId(Store store);
+  static std::unique_ptr<StorageBackend> createBackend(Backend kind);
 };
 
 #endif
@@ -11,6 +11,8 @@ public:
     static bool saveToBinary(const InventoryService& inventory, const std::string& filename);
     
     static bool loadFromBinary(InventoryService& inventory, const std::string& filename);
+    // Reads every product or nothing; a truncated file fails as a whole.
+    static bool readBinary(const std::string& filename, std::vector<Product>& products);
     
     static bool exportReportToText(const InventoryService& inventory, const std::string& filename);
     
@@ -0,0 +1,328 @@
+#ifndef FILESTORAGEBACKEND_H
+#define FILESTORAGEBACKEND_H
+
+#include "entities/Order.h"
+#include "entities/Product.h"
+#include "managers/FileSync.h"
+#include "managers/GroupCommit.h"
+#include "managers/ProductColumnFile.h"
+#include "managers/RecordLog.h"
+#include "managers/StorageBackend.h"
+#include "managers/StoreLock.h"
+#include <QBitArray>
+#include <QDataStream>
+#include <QDate>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FileStorageBackend : public StorageBackend {
+private:
+  QString dataFilePath;
+  QString productColumnsFilePath;
+  QString writeOffFilePath;
+  QString ordersFilePath;
+  QString ordersDirPath;
+  QString orderManifestFilePath;
+  QString orderIndexFilePath;
+  QString productCompactionLockFilePath;
+  std::map<Store, QString> lockFilePaths;
+  std::map<Store, std::atomic<quint64>> seenGenerations;
+  std::map<Store, std::shared_mutex> storeMutexes;
+
+  std::unique_ptr<ProductColumnFile> productColumns;
+  std::unique_ptr<RecordLog> productLog;
+  // The write-off journal holds bare records in the readWriteOffRecordFromFile
+  // layout, appended in id order. The last id and the end of the readable
+  // records come from scanning it, then follow this process's appends.
+  bool writeOffJournalOpen;
+  int lastWriteOffId;
+  qint64 writeOffJournalEnd;
+  QHash<int, qint64> productOffsets;
+  int productLogRecords;
+  std::mutex productLogMutex;
+  std::thread compactionThread;
+  // Set by writers and cleared by the compaction thread.
+  std::atomic<bool> compactionRunning;
+
+  struct OrderLocation {
+    int segment = 0;
+    qint64 offset = 0;
+    qint64 length = 0;
+  };
+
+  struct OrderSegment {
+    QDate minDate;
+    QDate maxDate;
+    int liveOrders = 0;
+    int deadRecords = 0;
+    qint64 size = 0;
+    bool frozen = false;
+  };
+
+  struct OrderKeys {
+    QString company;
+    OrderType type;
+
+    OrderKeys() : type(OrderType::RETAIL) {}
+  };
+
+  struct OrderDictionary {
+    QStringList strings;
+    QHash<QString, quint32> refs;
+    qsizetype persisted = 0;
+    bool loaded = false;
+  };
+
+  std::map<int, OrderSegment> orderSegments;
+  std::map<int, OrderDictionary> orderDictionaries;
+  std::mutex orderDictionaryMutex;
+  bool orderManifestDirty;
+  QHash<int, OrderLocation> orderIndex;
+  QHash<int, OrderKeys> orderKeys;
+  std::map<QString, QSet<int>> companyPostings;
+  QHash<int, QBitArray> orderTypeBitmaps;
+
+  struct FileStamp {
+    qint64 size = -1;
+    QDateTime modified;
+
+    bool operator==(const FileStamp &other) const {
+      return size == other.size && modified == other.modified;
+    }
+    bool operator!=(const FileStamp &other) const { return !(*this == other); }
+  };
+
+  std::unique_ptr<GroupCommit> groupCommit;
+  std::map<Store, Durability> durabilities;
+  // Filled by the scans that rebuild a store's index, which replace what
+  // the previous rebuild found; dictionaries add to it as they load.
+  std::map<Store, LoadReport> loadReports;
+  mutable std::mutex loadReportMutex;
+  // Batched commits made under a store's exclusive lock, waited for by the
+  // StoreAccess holding it.
+  std::map<Store, std::vector<std::shared_future<bool>>> pendingCommits;
+
+  bool residentCacheEnabled;
+  bool productsResident;
+  std::vector<Product> productCache;
+  QHash<int, size_t> productSlots;
+  FileStamp productStamp;
+  bool ordersResident;
+  std::vector<Order> orderCache;
+  QHash<int, size_t> orderSlots;
+  FileStamp ordersStamp;
+  bool writeOffsResident;
+  std::vector<WriteOffRecord> writeOffCache;
+  FileStamp writeOffStamp;
+  // Readers share a store, so the first one to need a resident cache fills
+  // it under this mutex while the others wait for it.
+  std::mutex residentFillMutex;
+
+public:
+  FileStorageBackend();
+  ~FileStorageBackend() override;
+
+  bool connect() override;
+  void disconnect() override;
+  bool isConnected() const override;
+
+  void setResidentCacheEnabled(bool enabled) override;
+  bool isResidentCacheEnabled() const override { return residentCacheEnabled; }
+
+  void setDurability(Store store, Durability durability) override;
+  Durability durability(Store store) const override;
+  bool flush() override;
+
+  int maxId(Store store) override;
+  LoadReport loadReport(Store store) const override;
+
+  bool addProduct(const Product &product) override;
+  bool updateProduct(const Product &product) override;
+  bool deleteProduct(int id) override;
+  std::vector<bool> addProducts(std::span<const Product> products) override;
+  std::vector<bool> updateProducts(std::span<const Product> products) override;
+  Product getProduct(int id) override;
+  std::vector<Product> getAllProducts() override;
+
+  std::vector<Product> searchProductsByName(const QString &name) override;
+  std::vector<Product>
+  searchProductsByCategory(const QString &category) override;
+  double calculateTotalInventoryValue() override;
+  int getTotalProductQuantity() override;
+
+  std::vector<bool>
+  addWriteOffRecords(std::span<const WriteOffRecord> records) override;
+  std::vector<QStringList> getWriteOffHistory() override;
+
+  bool addOrder(const Order &order) override;
+  std::vector<bool> addOrders(std::span<const Order> orders) override;
+  bool updateOrder(const Order &order) override;
+  bool deleteOrder(int id) override;
+  Order getOrder(int id) override;
+  std::vector<Order> getAllOrders() override;
+  bool forEachOrder(const std::function<void(const Order &)> &visitor) override;
+  std::vector<Order> getOrdersByCompany(const QString &companyName) override;
+  std::vector<Order> getOrdersByCompanyPrefix(const QString &prefix) override;
+  std::vector<Order> getOrdersByType(OrderType type) override;
+  std::vector<Order> getOrdersByDateRange(const QDate &startDate,
+                                          const QDate &endDate) override;
+  std::vector<Order> getOrders(std::vector<int> ids) override;
+
+  std::vector<OrderHeader> getOrderHeaders() override;
+  std::vector<OrderHeader>
+  getOrderHeadersByCompany(const QString &companyName) override;
+  std::vector<OrderHeader> getOrderHeadersByType(OrderType type) override;
+  std::vector<OrderHeader>
+  getOrderHeadersByDateRange(const QDate &startDate,
+                             const QDate &endDate) override;
+
+private:
+  // Threads share or take turns on a store in process before locking it on
+  // disk in the same mode. Readers overlap: what they fill lazily guards
+  // itself, and only a reload after another process commits makes a reader
+  // step up to the exclusive locks.
+  // A writer's access waits for its batched commits to reach disk after
+  // letting go of the store, so the writers queued behind it can share the
+  // same fsync.
+  struct StoreAccess {
+    std::shared_lock<std::shared_mutex> shared;
+    std::unique_lock<std::shared_mutex> exclusive;
+    std::unique_ptr<StoreLock> lock;
+    std::vector<std::shared_future<bool>> *commits = nullptr;
+
+    StoreAccess() = default;
+    StoreAccess(StoreAccess &&other) noexcept;
+    ~StoreAccess();
+  };
+
+  StoreAccess lockStore(Store store, StoreLock::Mode mode);
+  void reloadStore(Store store);
+  void commitWrite(Store store, const QString &filePath);
+  void clearLoadReport(Store store);
+  void noteSkips(Store store, const RecordLog::SkipReport &skips);
+  bool loadProducts(std::vector<Product> &products);
+  bool saveProducts(const std::vector<Product> &products);
+  bool openProductLog();
+  bool migrateLegacyProducts();
+  bool rebuildProductIndex();
+  void applyProductRecord(QHash<int, qint64> &offsets,
+                          const RecordLog::Record &record, int &logRecords);
+  bool appendProductRecord(RecordLog::Op op, int id,
+                           const QByteArray &payload);
+  std::vector<bool> writeProducts(std::span<const Product> products,
+                                  bool existingOnly);
+  void scheduleProductCompaction();
+  void compactProductLog(QHash<int, qint64> snapshot, qint64 snapshotEnd,
+                         FileStamp columnsStamp);
+  void waitForProductCompaction();
+  bool productExists(int id) const;
+  bool isOverriddenRow(int row) const;
+  Product productFromColumns(int row) const;
+  bool scanLiveProducts(const std::function<void(const Product &)> &visitor);
+  bool scanLogProducts(const std::function<void(const Product &)> &visitor);
+  bool visitProducts(const std::function<void(const Product &)> &visitor);
+  bool visitOrders(const std::function<void(const Order &)> &visitor);
+  static FileStamp stampOf(const QString &filePath);
+  bool ensureProductsResident();
+  bool ensureOrdersResident();
+  bool ensureWriteOffsResident();
+  bool residentForRead(Store store, bool fill = true);
+  void dropResidentCaches();
+  QByteArray encodeProduct(const Product &product);
+  bool decodeProduct(const QByteArray &payload, Product &product);
+  bool loadWriteOffRecords(std::vector<WriteOffRecord> &records);
+  bool openWriteOffJournal();
+  bool migrateFramedWriteOffs();
+  bool catchUpWriteOffJournal();
+  bool scanWriteOffJournal(
+      qint64 from, const std::function<void(const WriteOffRecord &)> &visitor,
+      qint64 &validEnd);
+  bool appendWriteOffRecords(std::span<const WriteOffRecord> records);
+  bool decodeWriteOff(const QByteArray &payload, WriteOffRecord &record);
+  void writeProductToFile(QDataStream &stream, const Product &product);
+  bool readProductFromFile(QDataStream &stream, Product &product);
+  void writeWriteOffRecordToFile(QDataStream &stream,
+                                 const WriteOffRecord &record);
+  bool readWriteOffRecordFromFile(QDataStream &stream, WriteOffRecord &record);
+  bool loadOrders(std::vector<Order> &orders);
+  bool scanOrderSegment(int segment,
+                        const std::function<void(const Order &)> &visitor);
+  bool scanOrderSegmentHeaders(
+      int segment, const std::function<void(const OrderHeader &)> &visitor);
+  bool scanLiveOrderRecords(
+      int segment, const std::function<void(const QByteArray &)> &visitor);
+  bool saveOrderSegment(int segment, const std::vector<Order> &orders);
+  bool openOrderSegments();
+  bool migrateLegacyOrders();
+  bool loadOrderManifest();
+  bool saveOrderManifest();
+  bool refreshOrderSegmentStats(int segment);
+  bool freezeOrderSegments();
+  bool compactOrderSegment(int segment);
+  bool loadOrderIndex();
+  bool rebuildOrderIndex();
+  bool saveOrderIndex();
+  void clearOrderIndex();
+  bool catchUpOrderSegment(QDataStream &stream, int segment, qint64 from);
+  void applyOrderIndexEntry(RecordLog::Op op, int id,
+                            const OrderLocation &location,
+                            const OrderKeys &keys);
+  static void writeOrderIndexEntry(QDataStream &stream, RecordLog::Op op,
+                                   int id, const OrderLocation &location,
+                                   const OrderKeys &keys);
+  void indexOrderKeys(int id, const OrderKeys &keys);
+  void unindexOrderKeys(int id);
+  static OrderKeys keysOf(const Order &order);
+  bool decodeOrderKeys(const QByteArray &payload, OrderKeys &keys);
+  std::vector<int> orderIdsByCompany(const QString &companyName) const;
+  std::vector<int> orderIdsByType(OrderType type) const;
+  std::vector<Order> readOrders(std::vector<int> ids);
+  std::vector<OrderHeader> readOrderHeaders(std::vector<int> ids);
+  bool readOrderRecords(const std::vector<int> &ids,
+                        const std::function<bool(int, const QByteArray &)>
+                            &visitor);
+  bool appendOrderRecord(RecordLog::Op op, int id, int segment,
+                         const QByteArray &payload,
+                         const OrderKeys &keys = OrderKeys());
+  void touchOrderManifest();
+  bool writeOrder(const Order &order);
+  std::vector<bool> writeOrders(std::span<const Order> orders);
+  QString orderSegmentPath(int segment) const;
+  static int orderSegmentKey(const QDate &date);
+  QString orderDictionaryPath(int segment) const;
+  OrderDictionary &orderDictionary(int segment);
+  static quint32 internOrderString(OrderDictionary &dictionary,
+                                   const QString &text);
+  bool persistOrderDictionary(int segment);
+  QByteArray encodeOrder(const Order &order, int segment);
+  bool decodeOrder(const QByteArray &payload, Order &order,
+                   const OrderDictionary *dictionary);
+  bool decodeOrderHeader(const QByteArray &payload, OrderHeader &header);
+  static OrderHeader headerOf(const Order &order);
+  void writeOrderToFile(QDataStream &stream, const Order &order,
+                        OrderDictionary &dictionary);
+  bool readOrderHeader(QDataStream &stream, OrderHeader &header, qint32 &tag);
+  bool readOrderFromFile(QDataStream &stream, Order &order,
+                         const OrderDictionary *dictionary);
+  bool readOrderItems(QDataStream &stream, Order &order, int itemsCount,
+                      const OrderDictionary *dictionary);
+  QString dateToString(const QDate &date);
+  QDate stringToDate(const QString &dateString);
+};
+
+#endif
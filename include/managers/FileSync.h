@@ -0,0 +1,18 @@
+#pragma once
+
+#include <QFileDevice>
+#include <QSaveFile>
+#include <QString>
+
+// Sync and Batched writes are on disk when they return; Batched ones share
+// an fsync with writes arriving within a short window. Async writes wait for
+// the next flush.
+enum class Durability { Sync, Batched, Async };
+
+class FileSync {
+public:
+  static bool syncFile(QFileDevice &file);
+  static bool syncPath(const QString &filePath);
+  static bool syncDirectory(const QString &dirPath);
+  static bool commit(QSaveFile &file);
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QSet>
+#include <QString>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+
+class GroupCommit {
+public:
+  explicit GroupCommit(int windowMs);
+  ~GroupCommit();
+
+  GroupCommit(const GroupCommit &) = delete;
+  GroupCommit &operator=(const GroupCommit &) = delete;
+
+  // The future becomes ready once the fsync covering filePath has run and
+  // holds whether it succeeded. Wait for it after giving up any lock other
+  // writers need, or they cannot join the same group.
+  std::shared_future<bool> schedule(const QString &filePath);
+  void defer(const QString &filePath);
+  bool flush();
+
+private:
+  void run();
+  std::promise<bool> takeGroup();
+  static bool syncAll(const QSet<QString> &paths);
+
+  int windowMs;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  QSet<QString> scheduled;
+  QSet<QString> deferred;
+  std::promise<bool> group;
+  std::shared_future<bool> groupDone;
+  bool syncing;
+  bool stopping;
+  std::thread worker;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "managers/IdSequence.h"
+#include <QString>
+#include <functional>
+#include <mutex>
+
+// Hands out ids for one entity type from a persisted sequence. Ids are
+// claimed from the file a block at a time under a lock shared with other
+// processes, so most calls touch no file and no two callers ever get the
+// same id. Ids left in a block when the process exits are never reused.
+// A sequence file that cannot be read is reseeded from highestUsedId, which
+// must not call back into the allocator.
+class IdAllocator {
+public:
+  IdAllocator(const QString &filePath, int blockSize,
+              std::function<int()> highestUsedId);
+
+  IdAllocator(const IdAllocator &) = delete;
+  IdAllocator &operator=(const IdAllocator &) = delete;
+
+  int next();
+  // First of count consecutive ids, or -1.
+  int reserve(int count);
+  // Keeps future ids above one that was assigned elsewhere.
+  bool advancePast(int id);
+
+private:
+  int claim(int count);
+  bool loadSequence();
+
+  IdSequence sequence;
+  std::function<int()> highestUsedId;
+  QString lockFilePath;
+  int blockSize;
+  std::mutex mutex;
+  int nextFree;
+  int blockEnd;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QString>
+
+class IdSequence {
+public:
+  explicit IdSequence(const QString &filePath);
+
+  const QString &path() const { return filePath; }
+  bool exists() const;
+  bool isLoaded() const { return loaded; }
+
+  // Fails on an unreadable file and leaves the sequence unloaded, so next
+  // and advanceTo refuse to hand out ids until it is reseeded.
+  bool load();
+  int next();
+  int current() const { return lastId; }
+  bool advanceTo(int id);
+  // Replaces whatever the file holds with id.
+  bool reseed(int id);
+
+private:
+  bool persist(int value);
+
+  QString filePath;
+  int lastId;
+  bool loaded;
+};
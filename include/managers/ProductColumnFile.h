@@ -0,0 +1,63 @@
+#pragma once
+
+#include "entities/Product.h"
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ProductColumnFile {
+public:
+  explicit ProductColumnFile(const QString &filePath);
+  ~ProductColumnFile();
+
+  ProductColumnFile(const ProductColumnFile &) = delete;
+  ProductColumnFile &operator=(const ProductColumnFile &) = delete;
+
+  const QString &path() const { return filePath; }
+
+  bool open();
+  void close();
+
+  int rowCount() const { return static_cast<int>(rows); }
+  int findRow(qint32 id) const;
+
+  qint32 idAt(int row) const;
+  qint32 quantityAt(int row) const;
+  double priceAt(int row) const;
+  quint32 nameRefAt(int row) const;
+  quint32 categoryRefAt(int row) const;
+
+  std::string stringAt(quint32 ref) const;
+  QString textAt(quint32 ref) const;
+
+  // Rows whose category matches case-insensitively, in row order. The
+  // category -> rows index is built once on first use, even when readers
+  // race for it, and dropped on close().
+  const std::vector<int> &rowsInCategory(const QString &category) const;
+
+  static bool write(QIODevice &device, const std::vector<Product> &products);
+
+private:
+  const uchar *column(qint64 offset, int row, int width) const;
+  bool heapEntry(quint32 ref, const char *&bytes, quint32 &length) const;
+
+  QString filePath;
+  QFile file;
+  uchar *data;
+  qint64 dataSize;
+  quint32 rows;
+  quint32 heapSize;
+  qint64 pricesOffset;
+  qint64 idsOffset;
+  qint64 quantitiesOffset;
+  qint64 nameRefsOffset;
+  qint64 categoryRefsOffset;
+  qint64 heapOffset;
+
+  mutable QHash<QString, std::vector<int>> categoryRows;
+  mutable bool categoryRowsBuilt;
+  mutable std::mutex categoryRowsMutex;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QString>
+#include <functional>
+#include <utility>
+#include <vector>
+
+class RecordLog {
+public:
+  enum class Op : quint8 { Upsert = 1, Tombstone = 2 };
+
+  struct Record {
+    Op op;
+    qint32 key;
+    qint64 offset;
+    qint64 length;
+    QByteArray payload;
+
+    Record() : op(Op::Upsert), key(0), offset(0), length(0) {}
+  };
+
+  // What a scan could not read: corrupt ranges it resynced past, as offset
+  // and length, and the bytes left at the end after the last good record.
+  struct SkipReport {
+    std::vector<std::pair<qint64, qint64>> skipped;
+    qint64 tailBytes = 0;
+
+    bool isClean() const { return skipped.empty() && tailBytes == 0; }
+  };
+
+  RecordLog(const QString &filePath, quint32 magic);
+
+  const QString &path() const { return filePath; }
+  qint64 size() const;
+
+  bool exists() const;
+  bool hasHeader() const;
+  bool create();
+  bool truncate(qint64 validEnd);
+
+  qint64 append(Op op, qint32 key, const QByteArray &payload,
+                qint64 *length = nullptr);
+  bool append(std::vector<Record> &records);
+  bool readAt(qint64 offset, Record &record) const;
+  bool scan(const std::function<void(const Record &)> &visitor,
+            qint64 from = -1, qint64 *validEnd = nullptr,
+            SkipReport *skips = nullptr) const;
+
+  void writeHeader(QDataStream &stream) const;
+  static qint64 headerSize();
+  // Reads the header at the stream's position and returns the format
+  // version it names, or 0 when it cannot be read.
+  static quint32 readVersion(QDataStream &stream);
+  static void writeRecord(QDataStream &stream, const Record &record);
+  // Unframed records are accepted only from a version 1 log.
+  static bool readRecord(QDataStream &stream, Record &record,
+                         quint32 version);
+
+private:
+  static bool readLegacyRecord(QDataStream &stream, Record &record);
+
+  QString filePath;
+  quint32 magic;
+};
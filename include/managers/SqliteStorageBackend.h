@@ -0,0 +1,121 @@
+#ifndef SQLITESTORAGEBACKEND_H
+#define SQLITESTORAGEBACKEND_H
+
+#include "entities/Order.h"
+#include "entities/Product.h"
+#include "managers/StorageBackend.h"
+#include <QDate>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <span>
+#include <vector>
+
+class SqliteStorageBackend : public StorageBackend {
+private:
+  QString databaseFilePath;
+  QString connectionPrefix;
+  QStringList connectionNames;
+  mutable std::mutex connectionMutex;
+  bool connected;
+  bool residentCacheEnabled;
+  std::map<Store, Durability> durabilities;
+
+public:
+  SqliteStorageBackend();
+  ~SqliteStorageBackend() override;
+
+  bool connect() override;
+  void disconnect() override;
+  bool isConnected() const override;
+
+  void setResidentCacheEnabled(bool enabled) override;
+  bool isResidentCacheEnabled() const override { return residentCacheEnabled; }
+
+  void setDurability(Store store, Durability durability) override;
+  Durability durability(Store store) const override;
+  bool flush() override;
+
+  int maxId(Store store) override;
+  // SQLite recovers its own pages, so nothing is ever reported skipped.
+  LoadReport loadReport(Store) const override { return LoadReport(); }
+
+  bool addProduct(const Product &product) override;
+  bool updateProduct(const Product &product) override;
+  bool deleteProduct(int id) override;
+  std::vector<bool> addProducts(std::span<const Product> products) override;
+  std::vector<bool> updateProducts(std::span<const Product> products) override;
+  Product getProduct(int id) override;
+  std::vector<Product> getAllProducts() override;
+
+  std::vector<Product> searchProductsByName(const QString &name) override;
+  std::vector<Product>
+  searchProductsByCategory(const QString &category) override;
+  double calculateTotalInventoryValue() override;
+  int getTotalProductQuantity() override;
+
+  std::vector<bool>
+  addWriteOffRecords(std::span<const WriteOffRecord> records) override;
+  std::vector<QStringList> getWriteOffHistory() override;
+
+  bool addOrder(const Order &order) override;
+  std::vector<bool> addOrders(std::span<const Order> orders) override;
+  bool updateOrder(const Order &order) override;
+  bool deleteOrder(int id) override;
+  Order getOrder(int id) override;
+  std::vector<Order> getAllOrders() override;
+  bool forEachOrder(const std::function<void(const Order &)> &visitor) override;
+  std::vector<Order> getOrdersByCompany(const QString &companyName) override;
+  std::vector<Order> getOrdersByCompanyPrefix(const QString &prefix) override;
+  std::vector<Order> getOrdersByType(OrderType type) override;
+  std::vector<Order> getOrdersByDateRange(const QDate &startDate,
+                                          const QDate &endDate) override;
+  std::vector<Order> getOrders(std::vector<int> ids) override;
+
+  std::vector<OrderHeader> getOrderHeaders() override;
+  std::vector<OrderHeader>
+  getOrderHeadersByCompany(const QString &companyName) override;
+  std::vector<OrderHeader> getOrderHeadersByType(OrderType type) override;
+  std::vector<OrderHeader>
+  getOrderHeadersByDateRange(const QDate &startDate,
+                             const QDate &endDate) override;
+
+private:
+  QSqlDatabase database();
+  bool createSchema(QSqlDatabase &db);
+  void applySynchronousMode(QSqlDatabase &db);
+  QString synchronousMode() const;
+  static bool run(QSqlQuery &query);
+  static bool run(QSqlQuery &query, const QString &statement);
+
+  std::vector<bool> writeProducts(std::span<const Product> products,
+                                  bool existingOnly);
+  static void bindProduct(QSqlQuery &query, const Product &product);
+  static Product productFromQuery(const QSqlQuery &query);
+  std::vector<Product> queryProducts(const QString &condition,
+                                     const QVariantList &values);
+
+  std::vector<bool> writeOrders(std::span<const Order> orders,
+                                bool existingOnly);
+  bool writeOrder(QSqlQuery &orderQuery, QSqlQuery &clearItems,
+                  QSqlQuery &itemQuery, const Order &order);
+  bool visitOrders(const QString &condition, const QVariantList &values,
+                   const std::function<void(const Order &)> &visitor);
+  std::vector<Order> queryOrders(const QString &condition,
+                                 const QVariantList &values);
+  std::vector<OrderHeader> queryOrderHeaders(const QString &condition,
+                                             const QVariantList &values);
+  static OrderHeader headerFromQuery(const QSqlQuery &query);
+  static QString companyKey(const QString &companyName);
+  static QString globPrefix(const QString &prefix);
+  static QString dateKey(const QDate &date);
+  static QString idList(const std::vector<int> &ids, size_t from,
+                        size_t count);
+};
+
+#endif
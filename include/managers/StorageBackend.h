@@ -0,0 +1,136 @@
+#ifndef STORAGEBACKEND_H
+#define STORAGEBACKEND_H
+
+#include "entities/Order.h"
+#include "entities/Product.h"
+#include "managers/FileSync.h"
+#include <QDate>
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct WriteOffRecord {
+  int id;
+  int productId;
+  std::string productName;
+  int quantity;
+  double value;
+  QString reason;
+
+  WriteOffRecord() : id(0), productId(0), quantity(0), value(0.0) {}
+};
+
+// Damage a backend stepped over while loading a store: corrupt records it
+// skipped to reach the next good one, and unreadable bytes it found at the
+// end of a file.
+struct LoadReport {
+  int skippedRanges;
+  qint64 skippedBytes;
+  qint64 tailBytes;
+
+  LoadReport() : skippedRanges(0), skippedBytes(0), tailBytes(0) {}
+
+  bool isClean() const { return skippedRanges == 0 && tailBytes == 0; }
+};
+
+struct OrderHeader {
+  int id;
+  QString companyName;
+  QString contactPerson;
+  QString phone;
+  OrderType orderType;
+  QDate orderDate;
+  int itemCount;
+  double totalAmount;
+  double totalDiscount;
+
+  OrderHeader()
+      : id(0), orderType(OrderType::RETAIL), itemCount(0), totalAmount(0.0),
+        totalDiscount(0.0) {}
+
+  explicit OrderHeader(const Order &order)
+      : id(order.getId()), companyName(order.getCompanyName()),
+        contactPerson(order.getContactPerson()), phone(order.getPhone()),
+        orderType(order.getOrderType()), orderDate(order.getOrderDate()),
+        itemCount(static_cast<int>(order.getItems().size())),
+        totalAmount(order.getTotalAmount()),
+        totalDiscount(order.getTotalDiscount()) {}
+
+  QString getOrderTypeString() const {
+    return orderType == OrderType::RETAIL ? "Retail" : "Wholesale";
+  }
+};
+
+// Persistence for products, orders and write-offs. DatabaseManager owns one
+// implementation and may call it from several threads at once: reads of one
+// store concurrently, but never alongside a write to that store. Those
+// reads should not wait on each other.
+class StorageBackend {
+public:
+  enum class Store { Products, Orders, WriteOffs };
+
+  virtual ~StorageBackend() = default;
+
+  virtual bool connect() = 0;
+  virtual void disconnect() = 0;
+  virtual bool isConnected() const = 0;
+
+  virtual void setResidentCacheEnabled(bool enabled) = 0;
+  virtual bool isResidentCacheEnabled() const = 0;
+
+  virtual void setDurability(Store store, Durability durability) = 0;
+  virtual Durability durability(Store store) const = 0;
+  virtual bool flush() = 0;
+
+  // Highest id in the store, answered from indexes without reading records.
+  virtual int maxId(Store store) = 0;
+  // What the latest full load of the store had to skip.
+  virtual LoadReport loadReport(Store store) const = 0;
+
+  virtual bool addProduct(const Product &product) = 0;
+  virtual bool updateProduct(const Product &product) = 0;
+  virtual bool deleteProduct(int id) = 0;
+  virtual std::vector<bool> addProducts(std::span<const Product> products) = 0;
+  virtual std::vector<bool>
+  updateProducts(std::span<const Product> products) = 0;
+  virtual Product getProduct(int id) = 0;
+  virtual std::vector<Product> getAllProducts() = 0;
+
+  virtual std::vector<Product> searchProductsByName(const QString &name) = 0;
+  virtual std::vector<Product>
+  searchProductsByCategory(const QString &category) = 0;
+  virtual double calculateTotalInventoryValue() = 0;
+  virtual int getTotalProductQuantity() = 0;
+
+  virtual std::vector<bool>
+  addWriteOffRecords(std::span<const WriteOffRecord> records) = 0;
+  virtual std::vector<QStringList> getWriteOffHistory() = 0;
+
+  virtual bool addOrder(const Order &order) = 0;
+  virtual std::vector<bool> addOrders(std::span<const Order> orders) = 0;
+  virtual bool updateOrder(const Order &order) = 0;
+  virtual bool deleteOrder(int id) = 0;
+  virtual Order getOrder(int id) = 0;
+  virtual std::vector<Order> getAllOrders() = 0;
+  virtual bool
+  forEachOrder(const std::function<void(const Order &)> &visitor) = 0;
+  virtual std::vector<Order> getOrdersByCompany(const QString &companyName) = 0;
+  virtual std::vector<Order>
+  getOrdersByCompanyPrefix(const QString &prefix) = 0;
+  virtual std::vector<Order> getOrdersByType(OrderType type) = 0;
+  virtual std::vector<Order> getOrdersByDateRange(const QDate &startDate,
+                                                  const QDate &endDate) = 0;
+  virtual std::vector<Order> getOrders(std::vector<int> ids) = 0;
+
+  virtual std::vector<OrderHeader> getOrderHeaders() = 0;
+  virtual std::vector<OrderHeader>
+  getOrderHeadersByCompany(const QString &companyName) = 0;
+  virtual std::vector<OrderHeader> getOrderHeadersByType(OrderType type) = 0;
+  virtual std::vector<OrderHeader>
+  getOrderHeadersByDateRange(const QDate &startDate, const QDate &endDate) = 0;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+// Advisory lock on a store's lock file, held for the lifetime of the
+// object. Shared locks coexist; an exclusive lock excludes everyone,
+// including other threads of the same process. The lock file also holds
+// the store's generation counter, which writers bump after each commit so
+// other processes know to reload.
+class StoreLock {
+public:
+  enum class Mode { Shared, Exclusive };
+
+  StoreLock(const QString &filePath, Mode mode, bool wait = true);
+  ~StoreLock();
+
+  StoreLock(const StoreLock &) = delete;
+  StoreLock &operator=(const StoreLock &) = delete;
+
+  bool isLocked() const { return locked; }
+  Mode mode() const { return lockMode; }
+
+  quint64 generation();
+  quint64 bumpGeneration();
+
+  // Bump the generation when this exclusive lock is released and record
+  // the new value, so the writer does not reload its own commit.
+  void publishTo(std::atomic<quint64> *seen) { published = seen; }
+
+private:
+  bool acquire(bool wait);
+  void release();
+
+  QFile file;
+  Mode lockMode;
+  bool locked;
+  std::atomic<quint64> *published;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QFuture>
+#include <QHash>
+#include <QPromise>
+#include <QString>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WriteQueue {
+public:
+  using Task = std::function<bool()>;
+  // Bit set naming what a task writes, so a reader can wait for just those
+  // writes. Tasks submitted without scopes count as writing everything.
+  using Scopes = quint32;
+  static constexpr Scopes ALL_SCOPES = ~Scopes(0);
+
+  explicit WriteQueue(size_t capacity);
+  ~WriteQueue();
+
+  WriteQueue(const WriteQueue &) = delete;
+  WriteQueue &operator=(const WriteQueue &) = delete;
+
+  QFuture<bool> submit(Task task);
+  QFuture<bool> submit(const QString &entity, const QString &operation,
+                       Task task);
+  QFuture<bool> submit(Scopes scopes, const QString &entity,
+                       const QString &operation, Task task);
+  void flush();
+  // Waits until no queued or running task writes any of scopes.
+  void flush(Scopes scopes);
+  bool isWriterThread() const;
+
+private:
+  struct Entry {
+    quint64 sequence = 0;
+    QString entity;
+    QString operation;
+    Scopes scopes = ALL_SCOPES;
+    Task task;
+    std::vector<std::shared_ptr<QPromise<bool>>> promises;
+  };
+
+  void run();
+  void countScopes(Scopes scopes, int delta);
+  bool isPending(Scopes scopes) const;
+
+  size_t capacity;
+  std::mutex mutex;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+  std::condition_variable drained;
+  std::deque<Entry> queue;
+  QHash<QString, quint64> lastForEntity;
+  std::array<int, 32> pendingPerScope;
+  quint64 nextSequence;
+  bool running;
+  bool stopping;
+  std::thread worker;
+};
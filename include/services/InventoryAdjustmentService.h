@@ -3,6 +3,8 @@
 #include "managers/DatabaseManager.h"
 #include "services/InventoryService.h"
 #include <QString>
+#include <QStringList>
+#include <span>
 
 class InventoryAdjustmentService {
 public:
@@ -10,9 +12,20 @@ public:
     int itemsUpdated = 0;
     int quantityAdded = 0;
     int quantityWrittenOff = 0;
+    QStringList errors;
+  };
+
+  struct Adjustment {
+    int id = 0;
+    int currentQty = 0;
+    int actualQty = 0;
   };
 
   static void applyAdjustment(InventoryService &inventory,
                               DatabaseManager *dbManager, int id,
                               int currentQty, int actualQty, Result &result);
+  static void applyAdjustments(InventoryService &inventory,
+                               DatabaseManager *dbManager,
+                               std::span<const Adjustment> adjustments,
+                               Result &result);
 };
@@ -1,34 +1,69 @@
 #pragma once
 
+#include "entities/DenseProductRepository.h"
 #include "entities/ProductRepository.h"
 #include "entities/Product.h"
+#include "managers/ChangeFeed.h"
 #include <vector>
 #include <memory>
+#include <set>
+
+class DatabaseManager;
 
 class InventoryService {
 private:
     ProductRepository<Product> repository;
+    // Column copy of the repository for totals and filters, kept in step by
+    // the mark* helpers that every change goes through. Filters take ids from
+    // it and products, in display order, from the repository.
+    DenseProductRepository columns;
     std::vector<std::shared_ptr<Product>> writeOffHistory;
 
+    // Products changed or removed since the last checkpoint.
+    DatabaseManager* store;
+    std::set<int> dirtyIds;
+    std::set<int> removedIds;
+    ChangeFeed feed;
+
+    void markDirty(int id);
+    void markRemoved(int id);
+    void markStockChanged(const Product& product);
+    void markUpserted(const Product& product);
+
 public:
+    using CategoryTotals = DenseProductRepository::CategoryTotals;
+
     InventoryService();
 
+    bool attachStore(DatabaseManager* dbManager);
+    bool checkpoint();
+    bool hasPendingChanges() const { return !dirtyIds.empty() || !removedIds.empty(); }
+    ChangeFeed* changes() { return &feed; }
+
     void addProduct(std::shared_ptr<Product> product);
     void updateProduct(int id, std::shared_ptr<Product> product);
     void deleteProduct(int id);
-    std::shared_ptr<Product> getProduct(int id) const;
-    std::vector<std::shared_ptr<Product>> getAllProducts() const;
+    // Products are handed out read-only: the repository's sorted indexes are
+    // keyed on their fields, so every change has to come through the methods
+    // here, which reindex.
+    std::shared_ptr<const Product> getProduct(int id) const;
+    std::vector<std::shared_ptr<const Product>> getAllProducts() const;
 
     void addStock(int id, int quantity);
     void removeStock(int id, int quantity);
     
-    std::vector<std::shared_ptr<Product>> searchProducts(const std::string& name) const;
-    std::vector<std::shared_ptr<Product>> filterByCategory(const std::string& category) const;
+    std::vector<std::shared_ptr<const Product>> searchProducts(const std::string& name) const;
+    std::vector<std::shared_ptr<const Product>> filterByCategory(const std::string& category) const;
+    std::vector<std::shared_ptr<const Product>> filterByPriceRange(double minPrice, double maxPrice) const;
+    std::vector<std::shared_ptr<const Product>> getLowStockProducts(int threshold) const;
+    std::vector<std::shared_ptr<const Product>> getTopProductsByQuantity(size_t count) const;
 
     double calculateTotalInventoryValue() const;
     double calculateTotalInventoryCost() const;
     int getTotalProductCount() const;
     int getTotalQuantity() const;
+    CategoryTotals getCategoryTotals(const std::string& category) const;
+    std::vector<std::pair<std::string, CategoryTotals>> getCategorySummary() const;
 
     void writeOffProduct(int id, int quantity, const std::string& reason);
     std::vector<std::shared_ptr<Product>> getWriteOffHistory() const { return writeOffHistory; }
@@ -38,7 +73,6 @@ public:
     void sortProductsByQuantity();
     void sortProductsByCategory();
 
-    ProductRepository<Product>& getRepository() { return repository; }
     const ProductRepository<Product>& getRepository() const { return repository; }
 };
 
@@ -3,14 +3,30 @@
 #include "entities/Order.h"
 #include "managers/DatabaseManager.h"
 #include "services/InventoryService.h"
+#include <QFuture>
+#include <vector>
 
 class OrderService {
 public:
+  struct StockChange {
+    int productId = 0;
+    int quantity = 0;
+  };
+
   struct Result {
-    bool saved = false;
+    QFuture<bool> saved;
     double totalAmount = 0.0;
+    std::vector<StockChange> stockChanges;
   };
 
-  static Result createOrder(InventoryService &inventory, DatabaseManager &db,
-                            const Order &order);
+  // Assigns a fresh id to an order that has none, takes its items out of
+  // stock right away so a later order cannot oversell them, and queues the
+  // order together with the changed products as one write. If the save
+  // fails the caller hands stockChanges to revertStockChanges.
+  static Result createOrder(DatabaseManager &db, InventoryService &inventory,
+                            Order &order);
+  static std::vector<StockChange> applyStockChanges(InventoryService &inventory,
+                                                    const Order &order);
+  static void revertStockChanges(InventoryService &inventory,
+                                 const std::vector<StockChange> &changes);
 };
@@ -8,7 +8,10 @@
 
 class ProductFilterService {
 public:
-  static std::vector<std::shared_ptr<Product>>
+  static std::vector<std::shared_ptr<const Product>>
   filterProducts(const InventoryService &inventory, const QString &category,
                  const QString &searchText);
+  // Whether filterProducts would include product.
+  static bool matches(const Product &product, const QString &category,
+                      const QString &searchText);
 };
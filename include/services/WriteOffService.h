@@ -2,13 +2,14 @@
 
 #include "managers/DatabaseManager.h"
 #include "services/InventoryService.h"
+#include <QFuture>
 #include <QString>
 
 class WriteOffService {
 public:
   struct Result {
     double writeOffValue;
-    bool dbRecordSaved;
+    QFuture<bool> dbRecordSaved;
   };
 
   static Result writeOffProduct(InventoryService &inventory,
@@ -25,6 +25,7 @@
 #include <QSpinBox>
 #include <QSplitter>
 #include <QTableView>
+#include <QTimer>
 #include <QTreeWidget>
 #include <QVBoxLayout>
 
@@ -75,6 +76,8 @@ private:
   void connectSignals();
   void setupSidebar();
   void setupContentArea();
+  void importLegacyInventory();
+  void reportLoadDamage();
 
   QWidget *createWarehouseSection();
   QWidget *createOrdersSection();
@@ -103,6 +106,7 @@ private:
   InventoryService *inventoryManager;
   DatabaseManager *dbManager;
   QString dataFilePath;
+  QTimer *checkpointTimer;
   QTextEdit *writeOffsReportTextEdit;
 
   void onSidebarItemClicked(QTreeWidgetItem *item, int column);
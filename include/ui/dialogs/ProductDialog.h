@@ -19,6 +19,7 @@ public:
     ProductDialog(const Product& product, QWidget* parent = nullptr);
     
     Product getProduct() const;
+    void setSuggestedId(int id);
     bool isEditMode() const { return editMode; }
 
 private slots:
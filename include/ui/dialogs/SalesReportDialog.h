@@ -8,6 +8,7 @@
 #include <QGroupBox>
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QLineEdit>
 #include <QPushButton>
 #include <QTableWidget>
 #include <QVBoxLayout>
@@ -39,6 +40,7 @@ private:
   QComboBox *reportTypeComboBox;
   QDateEdit *startDateEdit;
   QDateEdit *endDateEdit;
+  QLineEdit *companyLineEdit;
   QPushButton *exportButton;
   QTableWidget *reportTable;
   QLabel *totalRetailLabel;
@@ -47,6 +49,6 @@ private:
   QLabel *totalDiscountLabel;
   QLabel *ordersCountLabel;
 
-  std::vector<Order> currentOrders;
+  std::vector<OrderHeader> currentOrders;
   DatabaseManager *dbManager;
 };
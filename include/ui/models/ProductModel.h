@@ -1,9 +1,12 @@
 #pragma once
 
 #include <QAbstractTableModel>
+#include <QHash>
+#include <QString>
 #include <vector>
 #include <memory>
 #include "entities/Product.h"
+#include "managers/ChangeFeed.h"
 #include "services/InventoryService.h"
 
 class ProductModel : public QAbstractTableModel {
@@ -33,12 +36,30 @@ public:
                 int role = Qt::EditRole) override;
     Qt::ItemFlags flags(const QModelIndex& index) const override;
 
+    // Shows a fixed list; later changes update its rows but add none.
     void setProducts(const std::vector<Product>& products);
     Product getProduct(int row) const;
+    // Shows the products ProductFilterService matches and keeps following
+    // changes to them, including products that start or stop matching.
+    void setFilter(const QString& category, const QString& searchText);
     void refresh();
 
+private slots:
+    void applyChange(const ChangeEvent& event);
+
 private:
+    int rowOf(int id) const;
+    bool isShown(const Product& product) const;
+    void appendProduct(const Product& product);
+    void removeProductAt(int row);
+    void reindexFrom(int row);
+
     std::vector<Product> products;
+    QHash<int, int> rowsById;
+    QString filterCategory;
+    QString filterText;
+    bool fixedList;
     InventoryService* inventoryManager;
+    quint64 lastSequence;
 };
 
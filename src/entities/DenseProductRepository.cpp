@@ -0,0 +1,301 @@
+#include "entities/DenseProductRepository.h"
+#include <algorithm>
+#include <bit>
+
+static const size_t MIN_BUCKETS = 16;
+static const size_t MIN_DEAD_SLOTS_TO_COMPACT = 64;
+
+DenseProductRepository::StringRef
+DenseProductRepository::StringPool::intern(const std::string &value) {
+  auto it = refs.find(value);
+  if (it != refs.end()) {
+    return it->second;
+  }
+  StringRef ref = static_cast<StringRef>(values.size());
+  values.push_back(value);
+  refs.emplace(value, ref);
+  return ref;
+}
+
+DenseProductRepository::StringRef
+DenseProductRepository::StringPool::lookup(const std::string &value) const {
+  auto it = refs.find(value);
+  return it != refs.end() ? it->second : DEAD_REF;
+}
+
+void DenseProductRepository::fileSlot(std::uint32_t slot) {
+  StringRef ref = categoryRefs[slot];
+  if (ref >= categorySlots.size()) {
+    categorySlots.resize(categories.values.size());
+    categoryTotalsByRef.resize(categories.values.size());
+  }
+  std::vector<std::uint32_t> &posting = categorySlots[ref];
+  postingPositions[slot] = static_cast<std::uint32_t>(posting.size());
+  posting.push_back(slot);
+
+  CategoryTotals &totals = categoryTotalsByRef[ref];
+  totals.productCount++;
+  totals.totalQuantity += quantities[slot];
+  totals.totalValue += quantities[slot] * prices[slot];
+}
+
+void DenseProductRepository::unfileSlot(std::uint32_t slot) {
+  StringRef ref = categoryRefs[slot];
+  std::vector<std::uint32_t> &posting = categorySlots[ref];
+  std::uint32_t position = postingPositions[slot];
+  std::uint32_t last = posting.back();
+  posting[position] = last;
+  postingPositions[last] = position;
+  posting.pop_back();
+
+  CategoryTotals &totals = categoryTotalsByRef[ref];
+  totals.productCount--;
+  totals.totalQuantity -= quantities[slot];
+  totals.totalValue -= quantities[slot] * prices[slot];
+  if (totals.productCount == 0) {
+    totals = CategoryTotals();
+  }
+}
+
+size_t DenseProductRepository::bucketOf(int id) const {
+  return (static_cast<std::uint32_t>(id) * 0x9E3779B9u) >> hashShift;
+}
+
+std::uint32_t DenseProductRepository::slotOf(int id) const {
+  if (buckets.empty()) {
+    return FREE_BUCKET;
+  }
+  size_t mask = buckets.size() - 1;
+  for (size_t i = bucketOf(id);; i = (i + 1) & mask) {
+    const Bucket &bucket = buckets[i];
+    if (bucket.slot == FREE_BUCKET || bucket.id == id) {
+      return bucket.slot;
+    }
+  }
+}
+
+void DenseProductRepository::indexInsert(int id, std::uint32_t slot) {
+  // Keep the table at most three quarters full.
+  if ((size() + 1) * 4 > buckets.size() * 3) {
+    rehash(std::max(MIN_BUCKETS, buckets.size() * 2));
+  }
+  size_t mask = buckets.size() - 1;
+  size_t i = bucketOf(id);
+  while (buckets[i].slot != FREE_BUCKET) {
+    i = (i + 1) & mask;
+  }
+  buckets[i] = {id, slot};
+}
+
+void DenseProductRepository::indexErase(int id) {
+  if (buckets.empty()) {
+    return;
+  }
+  size_t mask = buckets.size() - 1;
+  size_t hole = bucketOf(id);
+  while (buckets[hole].slot != FREE_BUCKET && buckets[hole].id != id) {
+    hole = (hole + 1) & mask;
+  }
+  if (buckets[hole].slot == FREE_BUCKET) {
+    return;
+  }
+
+  // Pull later entries of the probe run back so lookups never stop early.
+  for (size_t next = (hole + 1) & mask; buckets[next].slot != FREE_BUCKET;
+       next = (next + 1) & mask) {
+    size_t home = bucketOf(buckets[next].id);
+    bool movable = hole <= next ? (home <= hole || home > next)
+                                : (home <= hole && home > next);
+    if (movable) {
+      buckets[hole] = buckets[next];
+      hole = next;
+    }
+  }
+  buckets[hole].slot = FREE_BUCKET;
+}
+
+void DenseProductRepository::rehash(size_t capacity) {
+  buckets.assign(capacity, {0, FREE_BUCKET});
+  hashShift = 32 - std::countr_zero(capacity);
+  size_t mask = capacity - 1;
+  for (std::uint32_t slot = 0; slot < ids.size(); ++slot) {
+    if (categoryRefs[slot] == DEAD_REF) {
+      continue;
+    }
+    size_t i = bucketOf(ids[slot]);
+    while (buckets[i].slot != FREE_BUCKET) {
+      i = (i + 1) & mask;
+    }
+    buckets[i] = {ids[slot], slot};
+  }
+}
+
+void DenseProductRepository::compact() {
+  size_t live = 0;
+  for (size_t slot = 0; slot < ids.size(); ++slot) {
+    if (categoryRefs[slot] == DEAD_REF) {
+      continue;
+    }
+    ids[live] = ids[slot];
+    quantities[live] = quantities[slot];
+    prices[live] = prices[slot];
+    nameRefs[live] = nameRefs[slot];
+    categoryRefs[live] = categoryRefs[slot];
+    live++;
+  }
+  ids.resize(live);
+  quantities.resize(live);
+  prices.resize(live);
+  nameRefs.resize(live);
+  categoryRefs.resize(live);
+  postingPositions.resize(live);
+  deadSlots = 0;
+  rehash(buckets.size());
+
+  // Slots were renumbered, so the category lists are rebuilt; this also
+  // clears any rounding the running value totals have picked up.
+  for (auto &posting : categorySlots) {
+    posting.clear();
+  }
+  std::fill(categoryTotalsByRef.begin(), categoryTotalsByRef.end(),
+            CategoryTotals());
+  for (std::uint32_t slot = 0; slot < live; ++slot) {
+    fileSlot(slot);
+  }
+}
+
+void DenseProductRepository::upsert(const Product &product) {
+  StringRef name = names.intern(product.getName());
+  StringRef category = categories.intern(product.getCategory());
+
+  std::uint32_t slot = slotOf(product.getId());
+  if (slot != FREE_BUCKET) {
+    unfileSlot(slot);
+    quantities[slot] = product.getQuantity();
+    prices[slot] = product.getUnitPrice();
+    nameRefs[slot] = name;
+    categoryRefs[slot] = category;
+    fileSlot(slot);
+    return;
+  }
+
+  slot = static_cast<std::uint32_t>(ids.size());
+  indexInsert(product.getId(), slot);
+  ids.push_back(product.getId());
+  quantities.push_back(product.getQuantity());
+  prices.push_back(product.getUnitPrice());
+  nameRefs.push_back(name);
+  categoryRefs.push_back(category);
+  postingPositions.push_back(0);
+  fileSlot(slot);
+}
+
+bool DenseProductRepository::remove(int id) {
+  std::uint32_t slot = slotOf(id);
+  if (slot == FREE_BUCKET) {
+    return false;
+  }
+  indexErase(id);
+  unfileSlot(slot);
+
+  // A dead slot adds nothing to the totals and matches no filter, so the
+  // scans need no liveness check.
+  quantities[slot] = 0;
+  prices[slot] = 0.0;
+  nameRefs[slot] = DEAD_REF;
+  categoryRefs[slot] = DEAD_REF;
+  deadSlots++;
+
+  if (deadSlots >= MIN_DEAD_SLOTS_TO_COMPACT && deadSlots > size()) {
+    compact();
+  }
+  return true;
+}
+
+void DenseProductRepository::clear() {
+  ids.clear();
+  quantities.clear();
+  prices.clear();
+  nameRefs.clear();
+  categoryRefs.clear();
+  postingPositions.clear();
+  deadSlots = 0;
+  names = StringPool();
+  categories = StringPool();
+  categorySlots.clear();
+  categoryTotalsByRef.clear();
+  buckets.clear();
+  hashShift = 32;
+}
+
+double DenseProductRepository::totalValue() const {
+  double total = 0.0;
+  for (size_t slot = 0; slot < quantities.size(); ++slot) {
+    total += quantities[slot] * prices[slot];
+  }
+  return total;
+}
+
+int DenseProductRepository::totalQuantity() const {
+  int total = 0;
+  for (int quantity : quantities) {
+    total += quantity;
+  }
+  return total;
+}
+
+std::vector<int>
+DenseProductRepository::idsInCategory(const std::string &category) const {
+  std::vector<int> result;
+  StringRef ref = categories.lookup(category);
+  if (ref == DEAD_REF || ref >= categorySlots.size()) {
+    return result;
+  }
+  std::vector<std::uint32_t> matching = categorySlots[ref];
+  std::sort(matching.begin(), matching.end());
+  result.reserve(matching.size());
+  for (std::uint32_t slot : matching) {
+    result.push_back(ids[slot]);
+  }
+  return result;
+}
+
+std::vector<int>
+DenseProductRepository::idsWithNameContaining(const std::string &text) const {
+  // Each distinct string is searched once; the scan then only compares refs.
+  std::vector<char> matches(names.values.size());
+  for (size_t ref = 0; ref < names.values.size(); ++ref) {
+    matches[ref] = names.values[ref].find(text) != std::string::npos;
+  }
+
+  std::vector<int> result;
+  for (size_t slot = 0; slot < nameRefs.size(); ++slot) {
+    StringRef ref = nameRefs[slot];
+    if (ref != DEAD_REF && matches[ref]) {
+      result.push_back(ids[slot]);
+    }
+  }
+  return result;
+}
+
+DenseProductRepository::CategoryTotals
+DenseProductRepository::categoryTotals(const std::string &category) const {
+  StringRef ref = categories.lookup(category);
+  if (ref == DEAD_REF || ref >= categoryTotalsByRef.size()) {
+    return CategoryTotals();
+  }
+  return categoryTotalsByRef[ref];
+}
+
+std::vector<std::pair<std::string, DenseProductRepository::CategoryTotals>>
+DenseProductRepository::categorySummary() const {
+  std::vector<std::pair<std::string, CategoryTotals>> summary;
+  for (size_t ref = 0; ref < categoryTotalsByRef.size(); ++ref) {
+    if (categoryTotalsByRef[ref].productCount > 0) {
+      summary.emplace_back(categories.values[ref], categoryTotalsByRef[ref]);
+    }
+  }
+  std::sort(summary.begin(), summary.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+  return summary;
+}
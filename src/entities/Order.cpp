@@ -2,17 +2,13 @@
 #include "services/DiscountCalculator.h"
 #include <algorithm>
 
-int Order::nextId = 1;
-
-void Order::setNextId(int id) { nextId = id + 1; }
-
 Order::Order()
-    : id(nextId++), orderType(OrderType::RETAIL), totalAmount(0.0),
+    : id(0), orderType(OrderType::RETAIL), totalAmount(0.0),
       totalDiscount(0.0), orderDate(QDate::currentDate()) {}
 
 Order::Order(const QString &company, const QString &contact,
              const QString &phoneNum, OrderType type)
-    : id(nextId++), companyName(company), contactPerson(contact),
+    : id(0), companyName(company), contactPerson(contact),
       phone(phoneNum), orderType(type), totalAmount(0.0), totalDiscount(0.0),
       orderDate(QDate::currentDate()) {}
 
@@ -6,10 +6,6 @@
 #include <sstream>
 
 
-int Product::nextId = 1;
-
-void Product::setNextId(int id) { nextId = id + 1; }
-
 Product::Product(const std::string &name, const std::string &category,
                  int quantity, double unitPrice)
     : AbstractProduct(name, category, quantity, unitPrice), id(0) {}
@@ -0,0 +1,15 @@
+#include "managers/ChangeFeed.h"
+
+ChangeFeed::ChangeFeed(QObject *parent) : QObject(parent), sequence(0) {
+  qRegisterMetaType<ChangeEvent>();
+}
+
+quint64 ChangeFeed::publish(ChangeEvent::Kind kind, int id, int quantity) {
+  ChangeEvent event;
+  event.sequence = ++sequence;
+  event.kind = kind;
+  event.id = id;
+  event.quantity = quantity;
+  emit changed(event);
+  return event.sequence;
+}
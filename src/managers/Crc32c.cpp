@@ -0,0 +1,129 @@
+#include "managers/Crc32c.h"
+#include <QtEndian>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRC32C_HAVE_SSE42
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define CRC32C_HAVE_ARMV8
+#include <arm_acle.h>
+#endif
+
+static const quint32 CRC32C_POLY = 0x82F63B78;
+
+using CrcTables = std::array<std::array<quint32, 256>, 8>;
+
+// Slicing-by-8: table k advances a byte that sits k positions before the end
+// of an 8-byte block.
+static constexpr CrcTables makeTables() {
+  CrcTables tables{};
+  for (quint32 i = 0; i < 256; ++i) {
+    quint32 crc = i;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+    }
+    tables[0][i] = crc;
+  }
+  for (size_t k = 1; k < tables.size(); ++k) {
+    for (size_t i = 0; i < 256; ++i) {
+      quint32 previous = tables[k - 1][i];
+      tables[k][i] = (previous >> 8) ^ tables[0][previous & 0xFF];
+    }
+  }
+  return tables;
+}
+
+static constexpr CrcTables TABLES = makeTables();
+
+static quint32 updateSoftware(quint32 crc, const uchar *data, size_t size) {
+  while (size >= 8) {
+    quint32 low = qFromLittleEndian<quint32>(data) ^ crc;
+    quint32 high = qFromLittleEndian<quint32>(data + 4);
+    crc = TABLES[7][low & 0xFF] ^ TABLES[6][(low >> 8) & 0xFF] ^
+          TABLES[5][(low >> 16) & 0xFF] ^ TABLES[4][low >> 24] ^
+          TABLES[3][high & 0xFF] ^ TABLES[2][(high >> 8) & 0xFF] ^
+          TABLES[1][(high >> 16) & 0xFF] ^ TABLES[0][high >> 24];
+    data += 8;
+    size -= 8;
+  }
+  while (size > 0) {
+    crc = (crc >> 8) ^ TABLES[0][(crc ^ *data++) & 0xFF];
+    size--;
+  }
+  return crc;
+}
+
+#if defined(CRC32C_HAVE_SSE42)
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("sse4.2")))
+#endif
+static quint32
+updateHardware(quint32 crc, const uchar *data, size_t size) {
+  quint64 wide = crc;
+  while (size >= 8) {
+    quint64 word;
+    std::memcpy(&word, data, sizeof(word));
+    wide = _mm_crc32_u64(wide, word);
+    data += 8;
+    size -= 8;
+  }
+  crc = static_cast<quint32>(wide);
+  while (size > 0) {
+    crc = _mm_crc32_u8(crc, *data++);
+    size--;
+  }
+  return crc;
+}
+
+static bool cpuHasCrc32c() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 20)) != 0;
+#else
+  return __builtin_cpu_supports("sse4.2");
+#endif
+}
+#elif defined(CRC32C_HAVE_ARMV8)
+static quint32 updateHardware(quint32 crc, const uchar *data, size_t size) {
+  while (size >= 8) {
+    quint64 word;
+    std::memcpy(&word, data, sizeof(word));
+    crc = __crc32cd(crc, word);
+    data += 8;
+    size -= 8;
+  }
+  while (size > 0) {
+    crc = __crc32cb(crc, *data++);
+    size--;
+  }
+  return crc;
+}
+
+static bool cpuHasCrc32c() { return true; }
+#endif
+
+using UpdateFunction = quint32 (*)(quint32, const uchar *, size_t);
+
+static UpdateFunction selectUpdate() {
+#if defined(CRC32C_HAVE_SSE42) || defined(CRC32C_HAVE_ARMV8)
+  if (cpuHasCrc32c()) {
+    return updateHardware;
+  }
+#endif
+  return updateSoftware;
+}
+
+quint32 Crc32c::update(quint32 crc, const void *data, size_t size) {
+  static const UpdateFunction implementation = selectUpdate();
+  return ~implementation(~crc, static_cast<const uchar *>(data), size);
+}
+
+bool Crc32c::isHardwareAccelerated() {
+  return selectUpdate() != updateSoftware;
+}
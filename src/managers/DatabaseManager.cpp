@@ -1,478 +1,403 @@
 #include "managers/DatabaseManager.h"
-#include "entities/Product.h"
-#include <QDataStream>
+#include "managers/FileStorageBackend.h"
+#ifdef HAVE_QT_SQL
+#include "managers/SqliteStorageBackend.h"
+#endif
 #include <QDebug>
 #include <QDir>
-#include <QFile>
-#include <QFileInfo>
-#include <QIODevice>
+#include <QSettings>
 #include <QStandardPaths>
 #include <algorithm>
-#include <cstddef>
-#include <exception>
-#include <stdexcept>
-#include <vector>
 
+static const size_t WRITE_QUEUE_CAPACITY = 1024;
+static const int ID_BLOCK_SIZE = 64;
 
-DatabaseManager *DatabaseManager::instance = nullptr;
+std::atomic<DatabaseManager *> DatabaseManager::instance = nullptr;
+std::mutex DatabaseManager::instanceMutex;
 
-DatabaseManager::DatabaseManager() {
+DatabaseManager::DatabaseManager()
+    : backend(createBackend(Backend::Files)), backendKind(Backend::Files),
+      residentCacheEnabled(false) {
+  storeMutexes[Store::Products];
+  storeMutexes[Store::Orders];
+  storeMutexes[Store::WriteOffs];
 
   QString dataPath =
       QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-  QDir dir;
-  if (!dir.exists(dataPath)) {
-    dir.mkpath(dataPath);
-  }
-  dataFilePath = dataPath + "/products.dat";
-  writeOffFilePath = dataPath + "/writeoff.dat";
-  ordersFilePath = dataPath + "/orders.dat";
+  QDir().mkpath(dataPath);
+  idAllocators[Store::Products] = std::make_unique<IdAllocator>(
+      dataPath + "/products.seq", ID_BLOCK_SIZE,
+      [this] { return highestStoredId(Store::Products); });
+  idAllocators[Store::Orders] = std::make_unique<IdAllocator>(
+      dataPath + "/orders.seq", ID_BLOCK_SIZE,
+      [this] { return highestStoredId(Store::Orders); });
+
+  writeQueue = std::make_unique<WriteQueue>(WRITE_QUEUE_CAPACITY);
 }
 
-DatabaseManager::~DatabaseManager() {}
+DatabaseManager::~DatabaseManager() {
+  writeQueue.reset();
+  backend.reset();
+}
 
 DatabaseManager *DatabaseManager::getInstance() {
-  if (!instance) {
-    instance = new DatabaseManager();
+  DatabaseManager *current = instance.load(std::memory_order_acquire);
+  if (current) {
+    return current;
   }
-  return instance;
-}
 
-void DatabaseManager::destroyInstance() {
-  if (instance) {
-    delete instance;
-    instance = nullptr;
+  std::lock_guard<std::mutex> lock(instanceMutex);
+  current = instance.load(std::memory_order_relaxed);
+  if (!current) {
+    current = new DatabaseManager();
+    instance.store(current, std::memory_order_release);
   }
+  return current;
 }
 
-bool DatabaseManager::initializeDatabase() { return connect(); }
-
-bool DatabaseManager::connect() {
-
-  QIODevice::OpenMode appendMode = QIODevice::WriteOnly | QIODevice::Append;
-
-  {
-    QFile file(dataFilePath);
-    if (!file.open(appendMode)) {
-      qDebug() << "Cannot create/open products file:" << dataFilePath;
-      return false;
-    }
-  }
+void DatabaseManager::destroyInstance() {
+  std::lock_guard<std::mutex> lock(instanceMutex);
+  delete instance.exchange(nullptr);
+}
 
-  {
-    QFile writeOffFile(writeOffFilePath);
-    if (!writeOffFile.open(appendMode)) {
-      qDebug() << "Cannot create/open write-off file:" << writeOffFilePath;
-      return false;
-    }
+std::unique_ptr<StorageBackend> DatabaseManager::createBackend(Backend kind) {
+  switch (kind) {
+  case Backend::Files:
+    return std::make_unique<FileStorageBackend>();
+  case Backend::Sqlite:
+#ifdef HAVE_QT_SQL
+    return std::make_unique<SqliteStorageBackend>();
+#else
+    return nullptr;
+#endif
   }
-
-  {
-    QFile ordersFile(ordersFilePath);
-    if (!ordersFile.open(appendMode)) {
-      qDebug() << "Cannot create/open orders file:" << ordersFilePath;
-      return false;
-    }
-  }
-
-  return true;
+  return nullptr;
 }
 
-void DatabaseManager::disconnect() {}
-
-bool DatabaseManager::isConnected() const {
-
-  QFileInfo info(dataFilePath);
-  return info.exists() || info.dir().exists();
+bool DatabaseManager::isBackendAvailable(Backend kind) {
+#ifdef HAVE_QT_SQL
+  Q_UNUSED(kind);
+  return true;
+#else
+  return kind == Backend::Files;
+#endif
 }
 
-bool DatabaseManager::loadProducts(std::vector<Product> &products) {
-  products.clear();
-  QFile file(dataFilePath);
-  if (!file.exists()) {
-
+bool DatabaseManager::setBackend(Backend kind) {
+  awaitWrites();
+  auto lock = lockAllStores();
+  if (kind == backendKind) {
     return true;
   }
 
-  if (!file.open(QIODevice::ReadOnly)) {
+  auto replacement = createBackend(kind);
+  if (!replacement) {
+    qDebug() << "Storage backend is not available in this build";
     return false;
   }
 
-  if (file.size() == 0) {
-    file.close();
-    return true;
-  }
-
-  QDataStream in(&file);
-  in.setVersion(QDataStream::Qt_6_0);
-
-  Product product;
-  int maxId = 0;
-  while (!in.atEnd()) {
-    if (readProductFromFile(in, product)) {
-      products.push_back(product);
-      if (product.getId() > maxId) {
-        maxId = product.getId();
-      }
-    } else {
-      break;
-    }
-  }
-
-  file.close();
-  Product::setNextId(maxId);
+  backend->disconnect();
+  backend = std::move(replacement);
+  backendKind = kind;
+  backend->setResidentCacheEnabled(residentCacheEnabled);
   return true;
 }
 
-bool DatabaseManager::saveProducts(const std::vector<Product> &products) {
-  QFile file(dataFilePath);
-  QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Truncate;
-  if (!file.open(mode)) {
-    qDebug() << "Error opening products file for writing:" << dataFilePath;
-    return false;
-  }
-
-  QDataStream out(&file);
-  out.setVersion(QDataStream::Qt_6_0);
-
-  for (const auto &product : products) {
-    writeProductToFile(out, product);
+bool DatabaseManager::initializeDatabase() {
+  // The backend is a per-deployment choice: storage/backend=sqlite in the
+  // application settings selects SQLite, anything else the data files.
+  QString configured =
+      QSettings().value("storage/backend", "files").toString().toLower();
+  if (configured == "sqlite" && !setBackend(Backend::Sqlite)) {
+    qDebug() << "Falling back to file storage";
   }
-
-  file.close();
-  return true;
+  return connect();
 }
 
-bool DatabaseManager::loadWriteOffRecords(
-    std::vector<WriteOffRecord> &records) {
-  records.clear();
-  QFile file(writeOffFilePath);
-  if (!file.exists()) {
-
-    return true;
-  }
-
-  if (!file.open(QIODevice::ReadOnly)) {
-    return false;
-  }
-
-  if (file.size() == 0) {
-    file.close();
-    return true;
-  }
-
-  QDataStream in(&file);
-  in.setVersion(QDataStream::Qt_6_0);
-
-  WriteOffRecord record;
-  while (!in.atEnd()) {
-    if (readWriteOffRecordFromFile(in, record)) {
-      records.push_back(record);
-    } else {
-      break;
+bool DatabaseManager::connect() {
+  awaitWrites();
+  {
+    auto lock = lockAllStores();
+    if (!backend->connect()) {
+      return false;
     }
   }
-
-  file.close();
+  seedIdAllocators();
   return true;
 }
 
-bool DatabaseManager::saveWriteOffRecords(
-    const std::vector<WriteOffRecord> &records) {
-  QFile file(writeOffFilePath);
-  QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Truncate;
-  if (!file.open(mode)) {
-    qDebug() << "Error opening write-off file for writing:" << writeOffFilePath;
-    return false;
+// Data written before the sequences existed, or by another backend, keeps
+// its ids; the sequences only ever move past them. Allocators take their
+// own locks before store locks, so no store is held here.
+void DatabaseManager::seedIdAllocators() {
+  for (auto &entry : idAllocators) {
+    entry.second->advancePast(highestStoredId(entry.first));
   }
-
-  QDataStream out(&file);
-  out.setVersion(QDataStream::Qt_6_0);
-
-  for (const auto &record : records) {
-    writeWriteOffRecordToFile(out, record);
-  }
-
-  file.close();
-  return true;
 }
 
-void DatabaseManager::writeProductToFile(QDataStream &stream,
-                                         const Product &product) {
-
-  stream << static_cast<qint32>(product.getId());
-
-  QString name = QString::fromStdString(product.getName());
-  stream << name;
-
-  QString category = QString::fromStdString(product.getCategory());
-  stream << category;
+int DatabaseManager::highestStoredId(Store store) {
+  auto lock = lockForRead(store);
+  return backend->maxId(store);
+}
 
-  stream << static_cast<qint32>(product.getQuantity());
+void DatabaseManager::disconnect() {
+  awaitWrites();
+  auto lock = lockAllStores();
+  backend->disconnect();
+}
 
-  stream << product.getUnitPrice();
+bool DatabaseManager::isConnected() const {
+  std::shared_lock<std::shared_mutex> lock(storeMutexes.at(Store::Products));
+  return backend->isConnected();
+}
 
-  QString productType = QString::fromStdString(product.getProductType());
-  stream << productType;
+LoadReport DatabaseManager::loadReport(Store store) {
+  auto lock = lockForRead(store);
+  return backend->loadReport(store);
 }
 
-bool DatabaseManager::readProductFromFile(QDataStream &stream,
-                                          Product &product) {
-  if (stream.atEnd()) {
-    return false;
-  }
+void DatabaseManager::setResidentCacheEnabled(bool enabled) {
+  awaitWrites();
+  auto lock = lockAllStores();
+  residentCacheEnabled = enabled;
+  backend->setResidentCacheEnabled(enabled);
+}
 
-  qint32 id;
-  stream >> id;
-  if (stream.status() != QDataStream::Ok) {
-    return false;
-  }
+void DatabaseManager::setDurability(Store store, Durability durability) {
+  awaitWrites();
+  auto lock = lockAllStores();
+  backend->setDurability(store, durability);
+}
 
-  QString name;
-  stream >> name;
-  if (stream.status() != QDataStream::Ok) {
-    return false;
-  }
+Durability DatabaseManager::durability(Store store) const {
+  std::shared_lock<std::shared_mutex> lock(storeMutexes.at(store));
+  return backend->durability(store);
+}
 
-  QString category;
-  stream >> category;
-  if (stream.status() != QDataStream::Ok) {
-    return false;
-  }
+bool DatabaseManager::flush() {
+  awaitWrites();
+  auto lock = lockAllStores();
+  return backend->flush();
+}
 
-  qint32 quantity;
-  stream >> quantity;
-  if (stream.status() != QDataStream::Ok) {
-    return false;
-  }
+static WriteQueue::Scopes scopeOf(DatabaseManager::Store store) {
+  return WriteQueue::Scopes(1) << static_cast<int>(store);
+}
 
-  double unitPrice;
-  stream >> unitPrice;
-  if (stream.status() != QDataStream::Ok) {
-    return false;
-  }
+void DatabaseManager::awaitWrites() { writeQueue->flush(); }
 
-  QString productType;
-  stream >> productType;
-  if (stream.status() != QDataStream::Ok) {
-    return false;
-  }
+void DatabaseManager::awaitWrites(Store store) {
+  writeQueue->flush(scopeOf(store));
+}
 
-  if (!stream.atEnd()) {
-    QDate dummyDate;
-    stream >> dummyDate;
-  }
+int DatabaseManager::nextProductId() {
+  return idAllocators.at(Store::Products)->next();
+}
 
-  product =
-      Product(name.toStdString(), category.toStdString(), quantity, unitPrice);
-  product.setId(id);
+int DatabaseManager::nextOrderId() {
+  return idAllocators.at(Store::Orders)->next();
+}
 
-  return true;
+int DatabaseManager::reserveProductIds(int count) {
+  return idAllocators.at(Store::Products)->reserve(count);
 }
 
-void DatabaseManager::writeWriteOffRecordToFile(QDataStream &stream,
-                                                const WriteOffRecord &record) {
+int DatabaseManager::reserveOrderIds(int count) {
+  return idAllocators.at(Store::Orders)->reserve(count);
+}
 
-  stream << static_cast<qint32>(record.id);
+// Plain reads do not wait for queued writes; callers that need to see their
+// own queued writes call awaitWrites(store) first.
+std::shared_lock<std::shared_mutex> DatabaseManager::lockForRead(Store store) {
+  return std::shared_lock<std::shared_mutex>(storeMutexes.at(store));
+}
 
-  stream << static_cast<qint32>(record.productId);
+// A direct write lands after the queued writes to its store, never under
+// them.
+std::unique_lock<std::shared_mutex> DatabaseManager::lockForWrite(Store store) {
+  awaitWrites(store);
+  return std::unique_lock<std::shared_mutex>(storeMutexes.at(store));
+}
 
-  QString name = QString::fromStdString(record.productName);
-  stream << name;
+// Also guards the backend pointer itself, which only changes with every store
+// held.
+std::scoped_lock<std::shared_mutex, std::shared_mutex, std::shared_mutex>
+DatabaseManager::lockAllStores() {
+  return std::scoped_lock<std::shared_mutex, std::shared_mutex,
+                          std::shared_mutex>(storeMutexes.at(Store::Products),
+                                             storeMutexes.at(Store::Orders),
+                                             storeMutexes.at(Store::WriteOffs));
+}
 
-  stream << static_cast<qint32>(record.quantity);
+static QString productEntity(int id) { return QString("product:%1").arg(id); }
 
-  stream << record.value;
+static QString orderEntity(int id) { return QString("order:%1").arg(id); }
 
-  stream << record.reason;
+QFuture<bool> DatabaseManager::addProductAsync(const Product &product) {
+  return writeQueue->submit(
+      scopeOf(Store::Products), productEntity(product.getId()), "add",
+      [this, product] { return addProduct(product); });
 }
 
-bool DatabaseManager::readWriteOffRecordFromFile(QDataStream &stream,
-                                                 WriteOffRecord &record) {
-  if (stream.atEnd()) {
-    return false;
-  }
-
-  qint32 id;
-  stream >> id;
-  if (stream.status() != QDataStream::Ok) {
-    return false;
-  }
-  record.id = id;
-
-  qint32 productId;
-  stream >> productId;
-  if (stream.status() != QDataStream::Ok) {
-    return false;
-  }
-  record.productId = productId;
+QFuture<bool> DatabaseManager::updateProductAsync(const Product &product) {
+  return writeQueue->submit(
+      scopeOf(Store::Products), productEntity(product.getId()), "update",
+      [this, product] { return updateProduct(product); });
+}
 
-  QString name;
-  stream >> name;
-  if (stream.status() != QDataStream::Ok) {
-    return false;
-  }
-  record.productName = name.toStdString();
+QFuture<bool> DatabaseManager::deleteProductAsync(int id) {
+  return writeQueue->submit(scopeOf(Store::Products), productEntity(id),
+                            QString(),
+                            [this, id] { return deleteProduct(id); });
+}
 
-  qint32 quantity;
-  stream >> quantity;
-  if (stream.status() != QDataStream::Ok) {
-    return false;
-  }
-  record.quantity = quantity;
+QFuture<bool> DatabaseManager::addOrderAsync(const Order &order) {
+  return writeQueue->submit(scopeOf(Store::Orders),
+                            orderEntity(order.getId()), "add",
+                            [this, order] { return addOrder(order); });
+}
 
-  double value;
-  stream >> value;
-  if (stream.status() != QDataStream::Ok) {
-    return false;
-  }
-  record.value = value;
+QFuture<bool>
+DatabaseManager::addOrderWithStockAsync(const Order &order,
+                                        std::vector<Product> products) {
+  return writeQueue->submit(
+      scopeOf(Store::Orders) | scopeOf(Store::Products),
+      orderEntity(order.getId()), "add", [this, order, products] {
+        if (!addOrder(order)) {
+          return false;
+        }
+        std::vector<bool> saved = updateProducts(products);
+        return std::all_of(saved.begin(), saved.end(),
+                           [](bool ok) { return ok; });
+      });
+}
 
-  QString reason;
-  stream >> reason;
-  if (stream.status() != QDataStream::Ok) {
-    return false;
-  }
-  record.reason = reason;
+QFuture<bool> DatabaseManager::updateOrderAsync(const Order &order) {
+  return writeQueue->submit(scopeOf(Store::Orders),
+                            orderEntity(order.getId()), "update",
+                            [this, order] { return updateOrder(order); });
+}
 
-  if (!stream.atEnd()) {
-    QDate dummyDate;
-    stream >> dummyDate;
-  }
+QFuture<bool> DatabaseManager::deleteOrderAsync(int id) {
+  return writeQueue->submit(scopeOf(Store::Orders), orderEntity(id),
+                            QString(),
+                            [this, id] { return deleteOrder(id); });
+}
 
-  return true;
+QFuture<bool> DatabaseManager::addWriteOffRecordAsync(
+    int productId, int quantity, double value, const QString &reason,
+    const QString &productName) {
+  return writeQueue->submit(
+      scopeOf(Store::WriteOffs), QString(), QString(), [=, this] {
+        return addWriteOffRecord(productId, quantity, value, reason,
+                                 productName);
+      });
 }
 
 bool DatabaseManager::addProduct(const Product &product) {
-  std::vector<Product> products;
-  if (!loadProducts(products)) {
-
-    products.clear();
-  }
-
-  auto it = std::find_if(
-      products.begin(), products.end(),
-      [&product](const Product &p) { return p.getId() == product.getId(); });
-
-  if (it != products.end()) {
-
-    *it = product;
-  } else {
-
-    products.push_back(product);
+  auto lock = lockForWrite(Store::Products);
+  if (!backend->addProduct(product)) {
+    return false;
   }
-
-  return saveProducts(products);
+  // Subscribers on this thread may read the store back, so the lock is
+  // released before anything is published.
+  lock.unlock();
+  idAllocators.at(Store::Products)->advancePast(product.getId());
+  feed.publish(ChangeEvent::Kind::ProductUpserted, product.getId(),
+               product.getQuantity());
+  return true;
 }
 
 bool DatabaseManager::updateProduct(const Product &product) {
-  std::vector<Product> products;
-  if (!loadProducts(products)) {
-    qDebug() << "Failed to load products for update";
+  auto lock = lockForWrite(Store::Products);
+  if (!backend->updateProduct(product)) {
     return false;
   }
-
-  auto it = std::find_if(
-      products.begin(), products.end(),
-      [&product](const Product &p) { return p.getId() == product.getId(); });
-
-  if (it != products.end()) {
-    *it = product;
-    if (!saveProducts(products)) {
-      qDebug() << "Failed to save products after update";
-      return false;
-    }
-    return true;
-  }
-
-  qDebug() << "Product with ID" << product.getId()
-           << "not found in database for update";
-  return false;
+  lock.unlock();
+  feed.publish(ChangeEvent::Kind::ProductUpserted, product.getId(),
+               product.getQuantity());
+  return true;
 }
 
 bool DatabaseManager::deleteProduct(int id) {
-  std::vector<Product> products;
-  if (!loadProducts(products)) {
+  auto lock = lockForWrite(Store::Products);
+  if (!backend->deleteProduct(id)) {
     return false;
   }
-
-  auto it = std::remove_if(products.begin(), products.end(),
-                           [id](const Product &p) { return p.getId() == id; });
-
-  if (it != products.end()) {
-    products.erase(it, products.end());
-    return saveProducts(products);
-  }
-
-  return false;
+  lock.unlock();
+  feed.publish(ChangeEvent::Kind::ProductRemoved, id);
+  return true;
 }
 
-Product DatabaseManager::getProduct(int id) {
-  std::vector<Product> products;
-  if (!loadProducts(products)) {
-    return Product();
+std::vector<bool>
+DatabaseManager::addProducts(std::span<const Product> products) {
+  auto lock = lockForWrite(Store::Products);
+  std::vector<bool> results = backend->addProducts(products);
+  lock.unlock();
+  int highest = 0;
+  for (size_t i = 0; i < products.size(); ++i) {
+    if (results[i]) {
+      highest = std::max(highest, products[i].getId());
+    }
   }
+  idAllocators.at(Store::Products)->advancePast(highest);
+  publishProducts(products, results);
+  return results;
+}
 
-  auto it = std::find_if(products.begin(), products.end(),
-                         [id](const Product &p) { return p.getId() == id; });
+std::vector<bool>
+DatabaseManager::updateProducts(std::span<const Product> products) {
+  auto lock = lockForWrite(Store::Products);
+  std::vector<bool> results = backend->updateProducts(products);
+  lock.unlock();
+  publishProducts(products, results);
+  return results;
+}
 
-  if (it != products.end()) {
-    return *it;
+void DatabaseManager::publishProducts(std::span<const Product> products,
+                                      const std::vector<bool> &results) {
+  for (size_t i = 0; i < products.size(); ++i) {
+    if (results[i]) {
+      feed.publish(ChangeEvent::Kind::ProductUpserted, products[i].getId(),
+                   products[i].getQuantity());
+    }
   }
+}
 
-  return Product();
+Product DatabaseManager::getProduct(int id) {
+  auto lock = lockForRead(Store::Products);
+  return backend->getProduct(id);
 }
 
 std::vector<Product> DatabaseManager::getAllProducts() {
-  std::vector<Product> products;
-  loadProducts(products);
-  return products;
+  auto lock = lockForRead(Store::Products);
+  return backend->getAllProducts();
 }
 
 std::vector<Product>
 DatabaseManager::searchProductsByName(const QString &name) {
-  std::vector<Product> allProducts;
-  if (!loadProducts(allProducts)) {
-    return std::vector<Product>();
-  }
-
-  std::vector<Product> results;
-  QString searchName = name.toLower();
-
-  for (const auto &product : allProducts) {
-    QString productName = QString::fromStdString(product.getName()).toLower();
-    if (productName.contains(searchName)) {
-      results.push_back(product);
-    }
-  }
-
-  return results;
+  auto lock = lockForRead(Store::Products);
+  return backend->searchProductsByName(name);
 }
 
 std::vector<Product>
 DatabaseManager::searchProductsByCategory(const QString &category) {
-  std::vector<Product> allProducts;
-  if (!loadProducts(allProducts)) {
-    return std::vector<Product>();
-  }
-
-  std::vector<Product> results;
-  QString searchCategory = category.toLower();
+  auto lock = lockForRead(Store::Products);
+  return backend->searchProductsByCategory(category);
+}
 
-  for (const auto &product : allProducts) {
-    QString productCategory =
-        QString::fromStdString(product.getCategory()).toLower();
-    if (productCategory == searchCategory) {
-      results.push_back(product);
-    }
-  }
+double DatabaseManager::calculateTotalInventoryValue() {
+  auto lock = lockForRead(Store::Products);
+  return backend->calculateTotalInventoryValue();
+}
 
-  return results;
+int DatabaseManager::getTotalProductQuantity() {
+  auto lock = lockForRead(Store::Products);
+  return backend->getTotalProductQuantity();
 }
 
 bool DatabaseManager::addWriteOffRecord(int productId, int quantity,
                                         double value, const QString &reason) {
-
   Product product = getProduct(productId);
   if (product.getId() == 0) {
     qDebug() << "Product not found for write-off record";
@@ -486,367 +411,145 @@ bool DatabaseManager::addWriteOffRecord(int productId, int quantity,
 bool DatabaseManager::addWriteOffRecord(int productId, int quantity,
                                         double value, const QString &reason,
                                         const QString &productName) {
-  try {
-    std::vector<WriteOffRecord> records;
-    if (!loadWriteOffRecords(records)) {
-
-      records.clear();
-    }
-
-    WriteOffRecord record;
-
-    if (records.empty()) {
-      record.id = 1;
-    } else {
-      int maxId = 0;
-      for (const auto &r : records) {
-        if (r.id > maxId) {
-          maxId = r.id;
-        }
-      }
-      record.id = maxId + 1;
+  WriteOffRecord record;
+  record.productId = productId;
+  record.productName = productName.toStdString();
+  record.quantity = quantity;
+  record.value = value;
+  record.reason = reason;
+  return addWriteOffRecords(std::span<const WriteOffRecord>(&record, 1))
+      .front();
+}
+
+std::vector<bool>
+DatabaseManager::addWriteOffRecords(std::span<const WriteOffRecord> records) {
+  auto lock = lockForWrite(Store::WriteOffs);
+  std::vector<bool> results = backend->addWriteOffRecords(records);
+  lock.unlock();
+  for (size_t i = 0; i < records.size(); ++i) {
+    if (results[i]) {
+      feed.publish(ChangeEvent::Kind::WriteOffAdded, records[i].productId,
+                   records[i].quantity);
     }
-
-    record.productId = productId;
-    record.productName = productName.toStdString();
-    record.quantity = quantity;
-    record.value = value;
-    record.reason = reason.isEmpty() ? QString("No reason provided") : reason;
-
-    records.push_back(record);
-    return saveWriteOffRecords(records);
-  } catch (const std::exception &e) {
-    qDebug() << "Exception in addWriteOffRecord:" << e.what();
-    return false;
-  } catch (...) {
-    qDebug() << "Unknown exception in addWriteOffRecord";
-    return false;
   }
+  return results;
 }
 
 std::vector<QStringList> DatabaseManager::getWriteOffHistory() {
-  std::vector<WriteOffRecord> records;
-  if (!loadWriteOffRecords(records)) {
-    return std::vector<QStringList>();
-  }
-
-  std::sort(records.begin(), records.end(),
-            [](const WriteOffRecord &a, const WriteOffRecord &b) {
-              return a.id > b.id;
-            });
-
-  std::vector<QStringList> history;
-  for (const auto &record : records) {
-    QStringList list;
-    list << QString::number(record.id);
-    list << QString::fromStdString(record.productName);
-    list << QString::number(record.quantity);
-    list << QString::number(record.value, 'f', 2);
-    list << record.reason;
-    history.push_back(list);
-  }
-
-  return history;
-}
-
-QDate DatabaseManager::stringToDate(const QString &dateString) {
-  return QDate::fromString(dateString, Qt::ISODate);
-}
-
-QString DatabaseManager::dateToString(const QDate &date) {
-  return date.toString(Qt::ISODate);
+  auto lock = lockForRead(Store::WriteOffs);
+  return backend->getWriteOffHistory();
 }
 
 bool DatabaseManager::addOrder(const Order &order) {
-  std::vector<Order> orders;
-  if (!loadOrders(orders)) {
-    orders.clear();
-  }
-
-  orders.push_back(order);
-  return saveOrders(orders);
-}
-
-std::vector<Order> DatabaseManager::getAllOrders() {
-  std::vector<Order> orders;
-  loadOrders(orders);
-  return orders;
-}
-
-std::vector<Order>
-DatabaseManager::getOrdersByCompany(const QString &companyName) {
-  std::vector<Order> allOrders;
-  if (!loadOrders(allOrders)) {
-    return std::vector<Order>();
-  }
-
-  std::vector<Order> results;
-  QString searchName = companyName.toLower();
-
-  for (const auto &order : allOrders) {
-    if (order.getCompanyName().toLower().contains(searchName)) {
-      results.push_back(order);
-    }
-  }
-
-  return results;
-}
-
-std::vector<Order> DatabaseManager::getOrdersByType(OrderType type) {
-  std::vector<Order> allOrders;
-  if (!loadOrders(allOrders)) {
-    return std::vector<Order>();
-  }
-
-  std::vector<Order> results;
-  for (const auto &order : allOrders) {
-    if (order.getOrderType() == type) {
-      results.push_back(order);
-    }
+  auto lock = lockForWrite(Store::Orders);
+  if (!backend->addOrder(order)) {
+    return false;
   }
-
-  return results;
+  lock.unlock();
+  idAllocators.at(Store::Orders)->advancePast(order.getId());
+  feed.publish(ChangeEvent::Kind::OrderAdded, order.getId());
+  return true;
 }
 
-std::vector<Order> DatabaseManager::getOrdersByDateRange(const QDate &startDate,
-                                                         const QDate &endDate) {
-  std::vector<Order> allOrders;
-  if (!loadOrders(allOrders)) {
-    return std::vector<Order>();
-  }
-
-  std::vector<Order> results;
-  for (const auto &order : allOrders) {
-    QDate orderDate = order.getOrderDate();
-    if (orderDate >= startDate && orderDate <= endDate) {
-      results.push_back(order);
+std::vector<bool> DatabaseManager::addOrders(std::span<const Order> orders) {
+  auto lock = lockForWrite(Store::Orders);
+  std::vector<bool> results = backend->addOrders(orders);
+  lock.unlock();
+  int highest = 0;
+  for (size_t i = 0; i < orders.size(); ++i) {
+    if (results[i]) {
+      highest = std::max(highest, orders[i].getId());
+      feed.publish(ChangeEvent::Kind::OrderAdded, orders[i].getId());
     }
   }
-
+  idAllocators.at(Store::Orders)->advancePast(highest);
   return results;
 }
 
 bool DatabaseManager::updateOrder(const Order &order) {
-  std::vector<Order> orders;
-  if (!loadOrders(orders)) {
+  auto lock = lockForWrite(Store::Orders);
+  if (!backend->updateOrder(order)) {
     return false;
   }
-
-  auto it =
-      std::find_if(orders.begin(), orders.end(), [&order](const Order &o) {
-        return o.getId() == order.getId();
-      });
-
-  if (it != orders.end()) {
-    *it = order;
-    return saveOrders(orders);
-  }
-
-  return false;
+  lock.unlock();
+  feed.publish(ChangeEvent::Kind::OrderUpdated, order.getId());
+  return true;
 }
 
 bool DatabaseManager::deleteOrder(int id) {
-  std::vector<Order> orders;
-  if (!loadOrders(orders)) {
+  auto lock = lockForWrite(Store::Orders);
+  if (!backend->deleteOrder(id)) {
     return false;
   }
-
-  auto it = std::remove_if(orders.begin(), orders.end(),
-                           [id](const Order &o) { return o.getId() == id; });
-
-  if (it != orders.end()) {
-    orders.erase(it, orders.end());
-    return saveOrders(orders);
-  }
-
-  return false;
+  lock.unlock();
+  feed.publish(ChangeEvent::Kind::OrderDeleted, id);
+  return true;
 }
 
 Order DatabaseManager::getOrder(int id) {
-  std::vector<Order> orders;
-  if (!loadOrders(orders)) {
-    return Order();
-  }
-
-  auto it = std::find_if(orders.begin(), orders.end(),
-                         [id](const Order &o) { return o.getId() == id; });
-
-  if (it != orders.end()) {
-    return *it;
-  }
-
-  return Order();
+  auto lock = lockForRead(Store::Orders);
+  return backend->getOrder(id);
 }
 
-bool DatabaseManager::loadOrders(std::vector<Order> &orders) {
-  orders.clear();
-  QFile file(ordersFilePath);
-  if (!file.exists()) {
-    return true;
-  }
-
-  if (!file.open(QIODevice::ReadOnly)) {
-    return false;
-  }
-
-  if (file.size() == 0) {
-    file.close();
-    return true;
-  }
-
-  QDataStream in(&file);
-  in.setVersion(QDataStream::Qt_6_0);
-
-  Order order;
-  int maxId = 0;
-  while (!in.atEnd()) {
-    if (readOrderFromFile(in, order)) {
-      orders.push_back(order);
-      if (order.getId() > maxId) {
-        maxId = order.getId();
-      }
-    } else {
-      break;
-    }
-  }
-
-  file.close();
-  Order::setNextId(maxId);
-  return true;
+std::vector<Order> DatabaseManager::getAllOrders() {
+  auto lock = lockForRead(Store::Orders);
+  return backend->getAllOrders();
 }
 
-bool DatabaseManager::saveOrders(const std::vector<Order> &orders) {
-  QFile file(ordersFilePath);
-  QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Truncate;
-  if (!file.open(mode)) {
-    qDebug() << "Error opening orders file for writing:" << ordersFilePath;
-    return false;
-  }
-
-  QDataStream out(&file);
-  out.setVersion(QDataStream::Qt_6_0);
-
-  for (const auto &order : orders) {
-    writeOrderToFile(out, order);
-  }
-
-  file.close();
-  return true;
+bool DatabaseManager::forEachOrder(
+    const std::function<void(const Order &)> &visitor) {
+  auto lock = lockForRead(Store::Orders);
+  return backend->forEachOrder(visitor);
 }
 
-void DatabaseManager::writeOrderToFile(QDataStream &stream,
-                                       const Order &order) {
-
-  stream << static_cast<qint32>(order.getId());
-
-  stream << order.getCompanyName();
-  stream << order.getContactPerson();
-  stream << order.getPhone();
-
-  stream << static_cast<qint32>(static_cast<int>(order.getOrderType()));
-
-  stream << order.getOrderDate();
-
-  const auto &items = order.getItems();
-  stream << static_cast<qint32>(items.size());
-
-  for (const auto &item : items) {
-    stream << static_cast<qint32>(item.productId);
-    stream << item.productName;
-    stream << item.category;
-    stream << static_cast<qint32>(item.quantity);
-    stream << item.unitPrice;
-    stream << item.discountPercent;
-    stream << item.totalPrice;
-  }
-
-  stream << order.getTotalAmount();
-  stream << order.getTotalDiscount();
+std::vector<Order>
+DatabaseManager::getOrdersByCompany(const QString &companyName) {
+  auto lock = lockForRead(Store::Orders);
+  return backend->getOrdersByCompany(companyName);
 }
 
-bool DatabaseManager::readOrderFromFile(QDataStream &stream, Order &order) {
-  if (stream.atEnd()) {
-    return false;
-  }
-
-  qint32 id;
-  stream >> id;
-  if (stream.status() != QDataStream::Ok)
-    return false;
-
-  QString companyName, contactPerson, phone;
-  stream >> companyName;
-  if (stream.status() != QDataStream::Ok)
-    return false;
-  stream >> contactPerson;
-  if (stream.status() != QDataStream::Ok)
-    return false;
-  stream >> phone;
-  if (stream.status() != QDataStream::Ok)
-    return false;
-
-  qint32 orderTypeInt;
-  stream >> orderTypeInt;
-  if (stream.status() != QDataStream::Ok)
-    return false;
-  OrderType orderType = static_cast<OrderType>(orderTypeInt);
-
-  QDate orderDate;
-  stream >> orderDate;
-  if (stream.status() != QDataStream::Ok)
-    return false;
+std::vector<Order>
+DatabaseManager::getOrdersByCompanyPrefix(const QString &prefix) {
+  auto lock = lockForRead(Store::Orders);
+  return backend->getOrdersByCompanyPrefix(prefix);
+}
 
-  order = Order(companyName, contactPerson, phone, orderType);
-  order.setId(id);
-  order.setOrderType(orderType);
-  order.setOrderDate(orderDate);
+std::vector<Order> DatabaseManager::getOrdersByType(OrderType type) {
+  auto lock = lockForRead(Store::Orders);
+  return backend->getOrdersByType(type);
+}
 
-  qint32 itemsCount;
-  stream >> itemsCount;
-  if (stream.status() != QDataStream::Ok)
-    return false;
+std::vector<Order> DatabaseManager::getOrdersByDateRange(const QDate &startDate,
+                                                         const QDate &endDate) {
+  auto lock = lockForRead(Store::Orders);
+  return backend->getOrdersByDateRange(startDate, endDate);
+}
 
-  for (int i = 0; i < itemsCount; ++i) {
-    qint32 productId;
-    QString productName, category;
-    qint32 quantity;
-    double unitPrice, discountPercent, totalPrice;
+std::vector<Order> DatabaseManager::getOrders(std::vector<int> ids) {
+  auto lock = lockForRead(Store::Orders);
+  return backend->getOrders(std::move(ids));
+}
 
-    stream >> productId;
-    if (stream.status() != QDataStream::Ok)
-      return false;
-    stream >> productName;
-    if (stream.status() != QDataStream::Ok)
-      return false;
-    stream >> category;
-    if (stream.status() != QDataStream::Ok)
-      return false;
-    stream >> quantity;
-    if (stream.status() != QDataStream::Ok)
-      return false;
-    stream >> unitPrice;
-    if (stream.status() != QDataStream::Ok)
-      return false;
-    stream >> discountPercent;
-    if (stream.status() != QDataStream::Ok)
-      return false;
-    stream >> totalPrice;
-    if (stream.status() != QDataStream::Ok)
-      return false;
+std::vector<OrderHeader> DatabaseManager::getOrderHeaders() {
+  auto lock = lockForRead(Store::Orders);
+  return backend->getOrderHeaders();
+}
 
-    OrderItem item(productId, productName, category, quantity, unitPrice);
-    item.discountPercent = discountPercent;
-    item.totalPrice = totalPrice;
-    order.addItem(item);
-  }
+std::vector<OrderHeader>
+DatabaseManager::getOrderHeadersByCompany(const QString &companyName) {
+  auto lock = lockForRead(Store::Orders);
+  return backend->getOrderHeadersByCompany(companyName);
+}
 
-  double totalAmount, totalDiscount;
-  stream >> totalAmount;
-  if (stream.status() != QDataStream::Ok)
-    return false;
-  stream >> totalDiscount;
-  if (stream.status() != QDataStream::Ok)
-    return false;
+std::vector<OrderHeader>
+DatabaseManager::getOrderHeadersByType(OrderType type) {
+  auto lock = lockForRead(Store::Orders);
+  return backend->getOrderHeadersByType(type);
+}
 
-  return true;
+std::vector<OrderHeader>
+DatabaseManager::getOrderHeadersByDateRange(const QDate &startDate,
+                                            const QDate &endDate) {
+  auto lock = lockForRead(Store::Orders);
+  return backend->getOrderHeadersByDateRange(startDate, endDate);
 }
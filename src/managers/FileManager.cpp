@@ -1,9 +1,11 @@
 
 #include "managers/FileManager.h"
+#include "managers/FileSync.h"
 #include "entities/Product.h"
 #include "services/InventoryService.h"
 #include "services/WriteOffCalculator.h"
 #include <QFile>
+#include <QSaveFile>
 #include <QDataStream>
 #include <QStandardPaths>
 #include <QDir>
@@ -14,7 +16,7 @@ static const quint32 FILE_MAGIC = 0x50524F44;
 
 bool FileManager::saveToBinary(const InventoryService& inventory, const std::string& filename) {
     try {
-        QFile file(QString::fromStdString(filename));
+        QSaveFile file(QString::fromStdString(filename));
         if (!file.open(QIODevice::WriteOnly)) {
             return false;
         }
@@ -48,14 +50,17 @@ bool FileManager::saveToBinary(const InventoryService& inventory, const std::str
             }
         }
         
-        file.close();
-        return true;
+        if (out.status() != QDataStream::Ok) {
+            file.cancelWriting();
+            return false;
+        }
+        return FileSync::commit(file);
     } catch (...) {
         return false;
     }
 }
 
-bool FileManager::loadFromBinary(InventoryService& inventory, const std::string& filename) {
+bool FileManager::readBinary(const std::string& filename, std::vector<Product>& products) {
     try {
         QFile file(QString::fromStdString(filename));
         if (!file.open(QIODevice::ReadOnly)) {
@@ -78,13 +83,10 @@ bool FileManager::loadFromBinary(InventoryService& inventory, const std::string&
         quint32 productCount;
         in >> productCount;
         
-        int maxId = 0;
+        std::vector<Product> loaded;
         for (quint32 i = 0; i < productCount; ++i) {
             qint32 id;
             in >> id;
-            if (id > maxId) {
-                maxId = id;
-            }
             
             QString name;
             in >> name;
@@ -101,23 +103,33 @@ bool FileManager::loadFromBinary(InventoryService& inventory, const std::string&
             QString productType;
             in >> productType;
             
-            auto product = std::make_shared<Product>(
-                name.toStdString(),
-                category.toStdString(),
-                quantity,
-                unitPrice
-            );
-            
-            product->setId(id);
+            if (in.status() != QDataStream::Ok) {
+                file.close();
+                return false;
+            }
             
-            inventory.addProduct(product);
-        }
-        
-        if (maxId > 0) {
-            Product::setNextId(maxId);
+            Product product(name.toStdString(), category.toStdString(), quantity, unitPrice);
+            product.setId(id);
+            loaded.push_back(product);
         }
         
         file.close();
+        products = std::move(loaded);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool FileManager::loadFromBinary(InventoryService& inventory, const std::string& filename) {
+    std::vector<Product> products;
+    if (!readBinary(filename, products)) {
+        return false;
+    }
+    try {
+        for (const auto& product : products) {
+            inventory.addProduct(std::make_shared<Product>(product));
+        }
         return true;
     } catch (...) {
         return false;
@@ -0,0 +1,3093 @@
+#include "managers/FileStorageBackend.h"
+#include "entities/Product.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+static const quint32 PRODUCT_LOG_MAGIC = 0x504C4F47;
+static const quint32 ORDER_LOG_MAGIC = 0x4F4C4F47;
+static const quint32 ORDER_INDEX_MAGIC = 0x4F494458;
+static const quint32 ORDER_INDEX_VERSION = 3;
+static const quint32 ORDER_MANIFEST_MAGIC = 0x4F4D414E;
+static const quint32 ORDER_MANIFEST_VERSION = 1;
+static const quint32 ORDER_DICT_MAGIC = 0x4F444943;
+static const quint32 WRITEOFF_LOG_MAGIC = 0x574C4F47;
+// Lead an order record whose items follow the header as one length-prefixed
+// block, with names and categories either inline or as references into the
+// segment dictionary. Legacy records start with the (positive) order id.
+static const qint32 ORDER_RECORD_TAG = -2;
+static const qint32 ORDER_RECORD_DICT_TAG = -3;
+static const int PRODUCT_COMPACTION_MIN_RECORDS = 256;
+static const int GROUP_COMMIT_WINDOW_MS = 10;
+static const qint64 PRODUCT_DELETED = -1;
+static const qint64 PRODUCT_NOT_IN_LOG = -2;
+
+template <typename T>
+static void upsertResident(std::vector<T> &cache, QHash<int, size_t> &slotIndex,
+                           const T &entity) {
+  auto it = slotIndex.constFind(entity.getId());
+  if (it != slotIndex.constEnd()) {
+    cache[it.value()] = entity;
+    return;
+  }
+
+  slotIndex.insert(entity.getId(), cache.size());
+  cache.push_back(entity);
+}
+
+// The last entity moves into the freed slot, so caches keep no order.
+template <typename T>
+static void eraseResident(std::vector<T> &cache, QHash<int, size_t> &slotIndex,
+                          int id) {
+  auto it = slotIndex.constFind(id);
+  if (it == slotIndex.constEnd()) {
+    return;
+  }
+
+  size_t slot = it.value();
+  slotIndex.remove(id);
+  if (slot + 1 != cache.size()) {
+    cache[slot] = std::move(cache.back());
+    slotIndex[cache[slot].getId()] = slot;
+  }
+  cache.pop_back();
+}
+
+// Order reads list ids in ascending order, whether they come from the
+// segments or from the unordered resident cache.
+static void sortById(std::vector<Order> &orders) {
+  std::sort(orders.begin(), orders.end(), [](const Order &a, const Order &b) {
+    return a.getId() < b.getId();
+  });
+}
+
+static void sortById(std::vector<OrderHeader> &headers) {
+  std::sort(headers.begin(), headers.end(),
+            [](const OrderHeader &a, const OrderHeader &b) {
+              return a.id < b.id;
+            });
+}
+
+FileStorageBackend::FileStorageBackend()
+    : productLogRecords(0), compactionRunning(false),
+      orderManifestDirty(false), residentCacheEnabled(false),
+      productsResident(false), ordersResident(false),
+      writeOffsResident(false) {
+
+  QString dataPath =
+      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+  QDir dir;
+  if (!dir.exists(dataPath)) {
+    dir.mkpath(dataPath);
+  }
+  dataFilePath = dataPath + "/products.dat";
+  productColumnsFilePath = dataPath + "/products.col";
+  writeOffFilePath = dataPath + "/writeoff.dat";
+  ordersFilePath = dataPath + "/orders.dat";
+  ordersDirPath = dataPath + "/orders";
+  orderManifestFilePath = ordersDirPath + "/manifest.dat";
+  orderIndexFilePath = ordersDirPath + "/orders.idx";
+  productCompactionLockFilePath = dataPath + "/products.compact.lock";
+  lockFilePaths[Store::Products] = dataPath + "/products.lock";
+  lockFilePaths[Store::Orders] = dataPath + "/orders.lock";
+  lockFilePaths[Store::WriteOffs] = dataPath + "/writeoff.lock";
+  seenGenerations[Store::Products] = 0;
+  seenGenerations[Store::Orders] = 0;
+  seenGenerations[Store::WriteOffs] = 0;
+  storeMutexes[Store::Products];
+  storeMutexes[Store::Orders];
+  storeMutexes[Store::WriteOffs];
+
+  productColumns = std::make_unique<ProductColumnFile>(productColumnsFilePath);
+  productLog = std::make_unique<RecordLog>(dataFilePath, PRODUCT_LOG_MAGIC);
+  writeOffJournalOpen = false;
+  lastWriteOffId = 0;
+  writeOffJournalEnd = 0;
+
+  groupCommit = std::make_unique<GroupCommit>(GROUP_COMMIT_WINDOW_MS);
+  durabilities[Store::Products] = Durability::Batched;
+  durabilities[Store::Orders] = Durability::Batched;
+  durabilities[Store::WriteOffs] = Durability::Batched;
+  pendingCommits[Store::Products];
+  pendingCommits[Store::Orders];
+  pendingCommits[Store::WriteOffs];
+  loadReports[Store::Products];
+  loadReports[Store::Orders];
+  loadReports[Store::WriteOffs];
+}
+
+FileStorageBackend::~FileStorageBackend() {
+  waitForProductCompaction();
+  flush();
+}
+
+bool FileStorageBackend::connect() {
+  // Opening may migrate or repair files, so each store is opened under its
+  // exclusive lock. A running compaction needs that lock to finish.
+  waitForProductCompaction();
+
+  {
+    auto lock = lockStore(Store::Products, StoreLock::Mode::Exclusive);
+    if (!openProductLog()) {
+      qDebug() << "Cannot create/open products file:" << dataFilePath;
+      return false;
+    }
+  }
+
+  {
+    auto lock = lockStore(Store::WriteOffs, StoreLock::Mode::Exclusive);
+    if (!openWriteOffJournal()) {
+      qDebug() << "Cannot create/open write-off file:" << writeOffFilePath;
+      return false;
+    }
+  }
+
+  {
+    auto lock = lockStore(Store::Orders, StoreLock::Mode::Exclusive);
+    if (!openOrderSegments()) {
+      qDebug() << "Cannot create/open orders directory:" << ordersDirPath;
+      return false;
+    }
+  }
+
+  if (residentCacheEnabled) {
+    {
+      std::lock_guard<std::mutex> lock(productLogMutex);
+      ensureProductsResident();
+    }
+    ensureOrdersResident();
+    ensureWriteOffsResident();
+  }
+
+  return true;
+}
+
+void FileStorageBackend::disconnect() {
+  waitForProductCompaction();
+  flush();
+}
+
+void FileStorageBackend::setDurability(Store store, Durability durability) {
+  durabilities[store] = durability;
+  if (durability == Durability::Sync) {
+    flush();
+  }
+}
+
+Durability FileStorageBackend::durability(Store store) const {
+  auto it = durabilities.find(store);
+  return it != durabilities.end() ? it->second : Durability::Sync;
+}
+
+bool FileStorageBackend::flush() {
+  bool ok = true;
+  std::lock_guard<std::shared_mutex> guard(storeMutexes.at(Store::Orders));
+  if (orderManifestDirty) {
+    StoreLock lock(lockFilePaths.at(Store::Orders), StoreLock::Mode::Exclusive);
+    ok = saveOrderManifest();
+  }
+  return groupCommit->flush() && ok;
+}
+
+int FileStorageBackend::maxId(Store store) {
+  auto storeLock = lockStore(store, StoreLock::Mode::Shared);
+  int id = 0;
+  switch (store) {
+  case Store::Products:
+    // Column rows are sorted by id, so only the delta log needs a pass.
+    if (productColumns->rowCount() > 0) {
+      id = productColumns->idAt(productColumns->rowCount() - 1);
+    }
+    for (auto it = productOffsets.constBegin(); it != productOffsets.constEnd();
+         ++it) {
+      id = std::max(id, it.key());
+    }
+    break;
+  case Store::Orders:
+    for (auto it = orderIndex.constBegin(); it != orderIndex.constEnd(); ++it) {
+      id = std::max(id, it.key());
+    }
+    break;
+  case Store::WriteOffs:
+    id = lastWriteOffId;
+    break;
+  }
+  return id;
+}
+
+LoadReport FileStorageBackend::loadReport(Store store) const {
+  std::lock_guard<std::mutex> lock(loadReportMutex);
+  return loadReports.at(store);
+}
+
+void FileStorageBackend::clearLoadReport(Store store) {
+  std::lock_guard<std::mutex> lock(loadReportMutex);
+  loadReports.at(store) = LoadReport();
+}
+
+void FileStorageBackend::noteSkips(Store store,
+                                   const RecordLog::SkipReport &skips) {
+  std::lock_guard<std::mutex> lock(loadReportMutex);
+  LoadReport &report = loadReports.at(store);
+  for (const auto &range : skips.skipped) {
+    report.skippedRanges++;
+    report.skippedBytes += range.second;
+  }
+  report.tailBytes += skips.tailBytes;
+}
+
+FileStorageBackend::StoreAccess
+FileStorageBackend::lockStore(Store store, StoreLock::Mode mode) {
+  const QString &path = lockFilePaths.at(store);
+  std::atomic<quint64> &seen = seenGenerations.at(store);
+
+  std::shared_mutex &mutex = storeMutexes.at(store);
+
+  StoreAccess access;
+  if (mode == StoreLock::Mode::Exclusive) {
+    access.exclusive = std::unique_lock<std::shared_mutex>(mutex);
+    access.commits = &pendingCommits.at(store);
+  } else {
+    access.shared = std::shared_lock<std::shared_mutex>(mutex);
+  }
+  for (;;) {
+    access.lock = std::make_unique<StoreLock>(path, mode);
+    StoreLock *lock = access.lock.get();
+    if (mode == StoreLock::Mode::Exclusive) {
+      lock->publishTo(&seen);
+    }
+    if (!lock->isLocked() || lock->generation() == seen) {
+      return access;
+    }
+
+    if (mode == StoreLock::Mode::Exclusive) {
+      reloadStore(store);
+      seen = lock->generation();
+      return access;
+    }
+
+    // Another process committed since this one last looked. Reloading can
+    // repair a torn tail and replaces what other readers are using, which
+    // only a writer may do, so readers step up to the exclusive locks for it
+    // and then retake the shared ones.
+    access.lock.reset();
+    access.shared.unlock();
+    bool reloaded = false;
+    {
+      std::lock_guard<std::shared_mutex> guard(mutex);
+      StoreLock writer(path, StoreLock::Mode::Exclusive);
+      if (writer.isLocked()) {
+        if (writer.generation() != seen) {
+          reloadStore(store);
+          seen = writer.generation();
+        }
+        reloaded = true;
+      }
+    }
+    access.shared.lock();
+    if (!reloaded) {
+      access.lock = std::make_unique<StoreLock>(path, mode);
+      return access;
+    }
+  }
+}
+
+FileStorageBackend::StoreAccess::StoreAccess(StoreAccess &&other) noexcept
+    : shared(std::move(other.shared)), exclusive(std::move(other.exclusive)),
+      lock(std::move(other.lock)),
+      commits(std::exchange(other.commits, nullptr)) {}
+
+FileStorageBackend::StoreAccess::~StoreAccess() {
+  std::vector<std::shared_future<bool>> pending;
+  if (commits) {
+    pending.swap(*commits);
+  }
+  lock.reset();
+  if (exclusive.owns_lock()) {
+    exclusive.unlock();
+  }
+  if (shared.owns_lock()) {
+    shared.unlock();
+  }
+
+  for (const auto &commit : pending) {
+    if (!commit.get()) {
+      qDebug() << "Batched commit did not reach disk";
+    }
+  }
+}
+
+void FileStorageBackend::reloadStore(Store store) {
+  switch (store) {
+  case Store::Products: {
+    std::lock_guard<std::mutex> lock(productLogMutex);
+    // While this process compacts no other process can replace the column
+    // file, and the merge is still reading the mapped one.
+    if (!compactionRunning) {
+      productColumns->close();
+      productColumns->open();
+    }
+    rebuildProductIndex();
+    productsResident = false;
+    productCache.clear();
+    productSlots.clear();
+    break;
+  }
+  case Store::Orders:
+    openOrderSegments();
+    ordersResident = false;
+    orderCache.clear();
+    orderSlots.clear();
+    break;
+  case Store::WriteOffs:
+    catchUpWriteOffJournal();
+    writeOffsResident = false;
+    writeOffCache.clear();
+    break;
+  }
+}
+
+void FileStorageBackend::commitWrite(Store store, const QString &filePath) {
+  switch (durability(store)) {
+  case Durability::Sync:
+    FileSync::syncPath(filePath);
+    break;
+  case Durability::Batched:
+    pendingCommits.at(store).push_back(groupCommit->schedule(filePath));
+    break;
+  case Durability::Async:
+    groupCommit->defer(filePath);
+    break;
+  }
+}
+
+bool FileStorageBackend::isConnected() const {
+
+  QFileInfo info(dataFilePath);
+  return info.exists() || info.dir().exists();
+}
+
+void FileStorageBackend::setResidentCacheEnabled(bool enabled) {
+  std::lock_guard<std::mutex> lock(productLogMutex);
+  residentCacheEnabled = enabled;
+  dropResidentCaches();
+}
+
+void FileStorageBackend::dropResidentCaches() {
+  productsResident = false;
+  productCache.clear();
+  productSlots.clear();
+
+  ordersResident = false;
+  orderCache.clear();
+  orderSlots.clear();
+
+  writeOffsResident = false;
+  writeOffCache.clear();
+}
+
+FileStorageBackend::FileStamp
+FileStorageBackend::stampOf(const QString &filePath) {
+  QFileInfo info(filePath);
+  FileStamp stamp;
+  if (info.exists()) {
+    stamp.size = info.size();
+    stamp.modified = info.lastModified();
+  }
+  return stamp;
+}
+
+bool FileStorageBackend::ensureProductsResident() {
+  if (!residentCacheEnabled) {
+    return false;
+  }
+
+  FileStamp stamp = stampOf(dataFilePath);
+  if (productsResident && stamp == productStamp) {
+    return true;
+  }
+
+  if (productsResident) {
+    qDebug() << "Products file changed on disk, reloading:" << dataFilePath;
+    rebuildProductIndex();
+  }
+
+  productCache.clear();
+  productSlots.clear();
+  productCache.reserve(productColumns->rowCount() + productOffsets.size());
+  if (!scanLiveProducts([this](const Product &product) {
+        upsertResident(productCache, productSlots, product);
+      })) {
+    productsResident = false;
+    return false;
+  }
+
+  productStamp = stampOf(dataFilePath);
+  productsResident = true;
+  return true;
+}
+
+bool FileStorageBackend::ensureOrdersResident() {
+  if (!residentCacheEnabled) {
+    return false;
+  }
+
+  FileStamp stamp = stampOf(orderIndexFilePath);
+  if (ordersResident && stamp == ordersStamp) {
+    return true;
+  }
+
+  ordersResident = false;
+  orderCache.clear();
+  orderSlots.clear();
+
+  std::vector<Order> orders;
+  if (!loadOrders(orders)) {
+    return false;
+  }
+  for (const auto &order : orders) {
+    upsertResident(orderCache, orderSlots, order);
+  }
+
+  ordersStamp = stamp;
+  ordersResident = true;
+  return true;
+}
+
+bool FileStorageBackend::ensureWriteOffsResident() {
+  if (!residentCacheEnabled) {
+    return false;
+  }
+
+  FileStamp stamp = stampOf(writeOffFilePath);
+  if (writeOffsResident && stamp == writeOffStamp) {
+    return true;
+  }
+
+  writeOffsResident = false;
+  if (!loadWriteOffRecords(writeOffCache)) {
+    writeOffCache.clear();
+    return false;
+  }
+
+  writeOffStamp = stamp;
+  writeOffsResident = true;
+  return true;
+}
+
+bool FileStorageBackend::residentForRead(Store store, bool fill) {
+  // Readers only ever fill a cache that is not resident yet, which nobody
+  // is reading. Rebuilding one that went stale would pull it out from under
+  // the other readers, so that waits for a writer and until then reads go
+  // to disk.
+  std::lock_guard<std::mutex> lock(residentFillMutex);
+  switch (store) {
+  case Store::Products:
+    if (productsResident || !fill) {
+      return productsResident && stampOf(dataFilePath) == productStamp;
+    }
+    return ensureProductsResident();
+  case Store::Orders:
+    if (ordersResident || !fill) {
+      return ordersResident && stampOf(orderIndexFilePath) == ordersStamp;
+    }
+    return ensureOrdersResident();
+  case Store::WriteOffs:
+    if (writeOffsResident || !fill) {
+      return writeOffsResident && stampOf(writeOffFilePath) == writeOffStamp;
+    }
+    return ensureWriteOffsResident();
+  }
+  return false;
+}
+
+bool FileStorageBackend::loadProducts(std::vector<Product> &products) {
+  products.clear();
+  return visitProducts(
+      [&](const Product &product) { products.push_back(product); });
+}
+
+bool FileStorageBackend::productExists(int id) const {
+  qint64 offset = productOffsets.value(id, PRODUCT_NOT_IN_LOG);
+  if (offset == PRODUCT_NOT_IN_LOG) {
+    return productColumns->findRow(id) >= 0;
+  }
+  return offset >= 0;
+}
+
+bool FileStorageBackend::isOverriddenRow(int row) const {
+  return !productOffsets.isEmpty() &&
+         productOffsets.contains(productColumns->idAt(row));
+}
+
+Product FileStorageBackend::productFromColumns(int row) const {
+  Product product(productColumns->stringAt(productColumns->nameRefAt(row)),
+                  productColumns->stringAt(productColumns->categoryRefAt(row)),
+                  productColumns->quantityAt(row), productColumns->priceAt(row));
+  product.setId(productColumns->idAt(row));
+  return product;
+}
+
+bool FileStorageBackend::scanLiveProducts(
+    const std::function<void(const Product &)> &visitor) {
+  for (int row = 0; row < productColumns->rowCount(); ++row) {
+    if (!isOverriddenRow(row)) {
+      visitor(productFromColumns(row));
+    }
+  }
+  return scanLogProducts(visitor);
+}
+
+bool FileStorageBackend::scanLogProducts(
+    const std::function<void(const Product &)> &visitor) {
+  Product product;
+  return productLog->scan([&](const RecordLog::Record &record) {
+    if (record.op != RecordLog::Op::Upsert ||
+        productOffsets.value(record.key, PRODUCT_NOT_IN_LOG) !=
+            record.offset) {
+      return;
+    }
+    if (decodeProduct(record.payload, product)) {
+      visitor(product);
+    }
+  });
+}
+
+bool FileStorageBackend::visitProducts(
+    const std::function<void(const Product &)> &visitor) {
+  if (residentForRead(Store::Products)) {
+    for (const auto &product : productCache) {
+      visitor(product);
+    }
+    return true;
+  }
+
+  return scanLiveProducts(visitor);
+}
+
+bool FileStorageBackend::visitOrders(
+    const std::function<void(const Order &)> &visitor) {
+  if (residentForRead(Store::Orders, false)) {
+    for (const auto &order : orderCache) {
+      visitor(order);
+    }
+    return true;
+  }
+
+  // Stream segment by segment instead of filling the resident cache, so a
+  // fold over every order needs memory for a single decoded record.
+  bool ok = true;
+  for (const auto &entry : orderSegments) {
+    if (entry.second.liveOrders > 0) {
+      ok = scanOrderSegment(entry.first, visitor) && ok;
+    }
+  }
+  return ok;
+}
+
+bool FileStorageBackend::saveProducts(const std::vector<Product> &products) {
+  QSaveFile file(dataFilePath);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qDebug() << "Error opening products file for writing:" << dataFilePath;
+    return false;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_6_0);
+
+  productLog->writeHeader(out);
+
+  RecordLog::Record record;
+  for (const auto &product : products) {
+    record.key = product.getId();
+    record.payload = encodeProduct(product);
+    RecordLog::writeRecord(out, record);
+  }
+
+  if (out.status() != QDataStream::Ok) {
+    file.cancelWriting();
+    return false;
+  }
+  return FileSync::commit(file);
+}
+
+bool FileStorageBackend::openProductLog() {
+  waitForProductCompaction();
+  std::lock_guard<std::mutex> lock(productLogMutex);
+
+  if (!productColumns->open()) {
+    return false;
+  }
+
+  if (productLog->exists() && productLog->size() > 0 &&
+      !productLog->hasHeader()) {
+    if (!migrateLegacyProducts()) {
+      return false;
+    }
+  }
+
+  if (!productLog->create()) {
+    return false;
+  }
+
+  if (!rebuildProductIndex()) {
+    return false;
+  }
+
+  scheduleProductCompaction();
+  return true;
+}
+
+bool FileStorageBackend::migrateLegacyProducts() {
+  QFile file(dataFilePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_6_0);
+
+  std::vector<Product> products;
+  Product product;
+  while (!in.atEnd()) {
+    if (readProductFromFile(in, product)) {
+      products.push_back(product);
+    } else {
+      break;
+    }
+  }
+  file.close();
+
+  qDebug() << "Migrating" << products.size()
+           << "products to the append-only log:" << dataFilePath;
+  return saveProducts(products);
+}
+
+bool FileStorageBackend::rebuildProductIndex() {
+  productOffsets.clear();
+  productLogRecords = 0;
+
+  qint64 validEnd = 0;
+  RecordLog::SkipReport skips;
+  bool ok = productLog->scan(
+      [this](const RecordLog::Record &record) {
+        applyProductRecord(productOffsets, record, productLogRecords);
+      },
+      -1, &validEnd, &skips);
+  if (!ok) {
+    qDebug() << "Error reading products log:" << dataFilePath;
+    return false;
+  }
+  clearLoadReport(Store::Products);
+  noteSkips(Store::Products, skips);
+
+  return productLog->truncate(validEnd);
+}
+
+void FileStorageBackend::applyProductRecord(QHash<int, qint64> &offsets,
+                                            const RecordLog::Record &record,
+                                            int &logRecords) {
+  offsets[record.key] = record.op == RecordLog::Op::Upsert ? record.offset
+                                                           : PRODUCT_DELETED;
+  logRecords++;
+}
+
+bool FileStorageBackend::appendProductRecord(RecordLog::Op op, int id,
+                                             const QByteArray &payload) {
+  qint64 offset = productLog->append(op, id, payload);
+  if (offset < 0) {
+    return false;
+  }
+  commitWrite(Store::Products, dataFilePath);
+
+  RecordLog::Record record;
+  record.op = op;
+  record.key = id;
+  record.offset = offset;
+  applyProductRecord(productOffsets, record, productLogRecords);
+
+  scheduleProductCompaction();
+  return true;
+}
+
+void FileStorageBackend::scheduleProductCompaction() {
+  if (compactionRunning || productLogRecords < PRODUCT_COMPACTION_MIN_RECORDS ||
+      productLogRecords * 4 < productColumns->rowCount()) {
+    return;
+  }
+
+  if (compactionThread.joinable()) {
+    compactionThread.join();
+  }
+
+  compactionRunning = true;
+  compactionThread = std::thread(&FileStorageBackend::compactProductLog, this,
+                                 productOffsets, productLog->size(),
+                                 stampOf(productColumnsFilePath));
+}
+
+void FileStorageBackend::compactProductLog(QHash<int, qint64> snapshot,
+                                           qint64 snapshotEnd,
+                                           FileStamp columnsStamp) {
+  // Only one process compacts at a time, and only from a snapshot taken
+  // against the column file that is still current.
+  StoreLock compactionLock(productCompactionLockFilePath,
+                           StoreLock::Mode::Exclusive, false);
+  if (!compactionLock.isLocked() ||
+      stampOf(productColumnsFilePath) != columnsStamp) {
+    compactionRunning = false;
+    return;
+  }
+
+  QList<int> keys = snapshot.keys();
+  std::vector<int> changedIds(keys.begin(), keys.end());
+  std::sort(changedIds.begin(), changedIds.end());
+
+  QFile in(dataFilePath);
+  bool ok = in.open(QIODevice::ReadOnly);
+
+  QDataStream reader(&in);
+  reader.setVersion(QDataStream::Qt_6_0);
+  quint32 logVersion = RecordLog::readVersion(reader);
+
+  RecordLog::Record record;
+  std::vector<Product> merged;
+  merged.reserve(productColumns->rowCount() + changedIds.size());
+
+  // The column file is immutable until it is replaced below, so the merge
+  // reads it without holding the lock.
+  int row = 0;
+  size_t changed = 0;
+  const int rows = productColumns->rowCount();
+  while (ok && (row < rows || changed < changedIds.size())) {
+    bool fromLog =
+        changed < changedIds.size() &&
+        (row >= rows || changedIds[changed] <= productColumns->idAt(row));
+    if (!fromLog) {
+      merged.push_back(productFromColumns(row++));
+      continue;
+    }
+
+    int id = changedIds[changed++];
+    if (row < rows && productColumns->idAt(row) == id) {
+      row++;
+    }
+
+    qint64 offset = snapshot.value(id);
+    if (offset == PRODUCT_DELETED) {
+      continue;
+    }
+
+    Product product;
+    if (!in.seek(offset) ||
+        !RecordLog::readRecord(reader, record, logVersion) ||
+        !decodeProduct(record.payload, product)) {
+      ok = false;
+      break;
+    }
+    merged.push_back(product);
+  }
+
+  QSaveFile columnsOut(productColumnsFilePath);
+  ok = ok && columnsOut.open(QIODevice::WriteOnly) &&
+       ProductColumnFile::write(columnsOut, merged);
+  merged.clear();
+  merged.shrink_to_fit();
+
+  StoreLock storeLock(lockFilePaths.at(Store::Products),
+                      StoreLock::Mode::Exclusive);
+  std::atomic<quint64> &seen = seenGenerations.at(Store::Products);
+  bool othersWrote = storeLock.generation() != seen;
+  storeLock.publishTo(&seen);
+  std::lock_guard<std::mutex> lock(productLogMutex);
+
+  // Records appended while the merge ran become the new delta log.
+  QSaveFile logOut(dataFilePath);
+  QHash<int, qint64> offsets;
+  int logRecords = 0;
+  if (ok && logOut.open(QIODevice::WriteOnly) && in.seek(snapshotEnd)) {
+    QDataStream writer(&logOut);
+    writer.setVersion(QDataStream::Qt_6_0);
+    productLog->writeHeader(writer);
+    while (!reader.atEnd()) {
+      if (!RecordLog::readRecord(reader, record, logVersion)) {
+        break;
+      }
+      record.offset = logOut.pos();
+      RecordLog::writeRecord(writer, record);
+      applyProductRecord(offsets, record, logRecords);
+    }
+    ok = writer.status() == QDataStream::Ok;
+  } else {
+    ok = false;
+  }
+  in.close();
+
+  // The old log replays idempotently over the new column file, so a crash
+  // between the two commits loses nothing.
+  if (ok) {
+    productColumns->close();
+    ok = FileSync::commit(columnsOut);
+    productColumns->open();
+  }
+  if (ok && FileSync::commit(logOut)) {
+    productOffsets = offsets;
+    productLogRecords = logRecords;
+    if (othersWrote) {
+      productsResident = false;
+    } else if (productsResident) {
+      productStamp = stampOf(dataFilePath);
+    }
+  } else {
+    qDebug() << "Products compaction failed:" << productColumnsFilePath;
+    if (othersWrote) {
+      rebuildProductIndex();
+      productsResident = false;
+    }
+  }
+
+  compactionRunning = false;
+}
+
+void FileStorageBackend::waitForProductCompaction() {
+  if (compactionThread.joinable()) {
+    compactionThread.join();
+  }
+}
+
+QByteArray FileStorageBackend::encodeProduct(const Product &product) {
+  QByteArray payload;
+  QDataStream out(&payload, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_6_0);
+  writeProductToFile(out, product);
+  return payload;
+}
+
+bool FileStorageBackend::decodeProduct(const QByteArray &payload,
+                                       Product &product) {
+  QDataStream in(payload);
+  in.setVersion(QDataStream::Qt_6_0);
+  return readProductFromFile(in, product);
+}
+
+bool FileStorageBackend::loadWriteOffRecords(
+    std::vector<WriteOffRecord> &records) {
+  records.clear();
+  qint64 validEnd = 0;
+  if (!scanWriteOffJournal(
+          0, [&records](const WriteOffRecord &record) {
+            records.push_back(record);
+          },
+          validEnd)) {
+    return false;
+  }
+
+  // Only a writer may cut a torn tail, so readers just leave it out.
+  qint64 size = QFileInfo(writeOffFilePath).size();
+  if (validEnd < size) {
+    qDebug() << "Ignoring" << size - validEnd
+             << "unreadable bytes at the end of:" << writeOffFilePath;
+  }
+  return true;
+}
+
+bool FileStorageBackend::openWriteOffJournal() {
+  writeOffJournalOpen = false;
+  if (RecordLog(writeOffFilePath, WRITEOFF_LOG_MAGIC).hasHeader() &&
+      !migrateFramedWriteOffs()) {
+    return false;
+  }
+
+  QFile file(writeOffFilePath);
+  if (!file.exists() && !file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  file.close();
+
+  // The next id used to be persisted beside the journal on every append;
+  // the journal's last record carries it now.
+  QFile::remove(QFileInfo(writeOffFilePath).dir().filePath("writeoff.seq"));
+
+  clearLoadReport(Store::WriteOffs);
+  lastWriteOffId = 0;
+  writeOffJournalEnd = 0;
+  writeOffJournalOpen = catchUpWriteOffJournal();
+  return writeOffJournalOpen;
+}
+
+// For a while the journal was a checksummed record log; it goes back to the
+// bare record layout so readWriteOffRecordFromFile reads it front to back.
+bool FileStorageBackend::migrateFramedWriteOffs() {
+  std::vector<WriteOffRecord> records;
+  WriteOffRecord record;
+  RecordLog log(writeOffFilePath, WRITEOFF_LOG_MAGIC);
+  if (!log.scan([&](const RecordLog::Record &entry) {
+        if (decodeWriteOff(entry.payload, record)) {
+          records.push_back(record);
+        }
+      })) {
+    return false;
+  }
+
+  qDebug() << "Migrating" << records.size()
+           << "write-off records back to the plain journal:"
+           << writeOffFilePath;
+
+  QSaveFile out(writeOffFilePath);
+  if (!out.open(QIODevice::WriteOnly)) {
+    qDebug() << "Error opening write-off file for writing:" << writeOffFilePath;
+    return false;
+  }
+
+  QDataStream writer(&out);
+  writer.setVersion(QDataStream::Qt_6_0);
+  for (const auto &stored : records) {
+    writeWriteOffRecordToFile(writer, stored);
+  }
+
+  if (writer.status() != QDataStream::Ok) {
+    out.cancelWriting();
+    return false;
+  }
+  return FileSync::commit(out);
+}
+
+// Reads records from the journal's tail as far as they last, so appends made
+// since the last look, here or by another process, move the last id on. A
+// torn record at the end is cut off so the next append stays readable.
+bool FileStorageBackend::catchUpWriteOffJournal() {
+  qint64 size = QFileInfo(writeOffFilePath).size();
+  if (size < writeOffJournalEnd) {
+    lastWriteOffId = 0;
+    writeOffJournalEnd = 0;
+  }
+  if (size == writeOffJournalEnd) {
+    return true;
+  }
+
+  qint64 validEnd = writeOffJournalEnd;
+  if (!scanWriteOffJournal(
+          writeOffJournalEnd,
+          [this](const WriteOffRecord &record) {
+            lastWriteOffId = std::max(lastWriteOffId, record.id);
+          },
+          validEnd)) {
+    return false;
+  }
+
+  if (validEnd < size) {
+    qDebug() << "Dropping incomplete tail of write-off journal:"
+             << writeOffFilePath << "at" << validEnd;
+    RecordLog::SkipReport skips;
+    skips.tailBytes = size - validEnd;
+    noteSkips(Store::WriteOffs, skips);
+    QFile file(writeOffFilePath);
+    if (!file.resize(validEnd)) {
+      return false;
+    }
+  }
+  writeOffJournalEnd = validEnd;
+  return true;
+}
+
+bool FileStorageBackend::scanWriteOffJournal(
+    qint64 from, const std::function<void(const WriteOffRecord &)> &visitor,
+    qint64 &validEnd) {
+  validEnd = from;
+  QFile file(writeOffFilePath);
+  if (!file.exists()) {
+    return true;
+  }
+  if (!file.open(QIODevice::ReadOnly) || !file.seek(from)) {
+    qDebug() << "Error opening write-off file:" << writeOffFilePath;
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_6_0);
+  WriteOffRecord record;
+  while (readWriteOffRecordFromFile(in, record)) {
+    validEnd = file.pos();
+    visitor(record);
+  }
+  file.close();
+  return true;
+}
+
+// Appends the records in one write; on failure the journal is cut back so
+// nothing half written is left for readers or the next append.
+bool FileStorageBackend::appendWriteOffRecords(
+    std::span<const WriteOffRecord> records) {
+  QFile file(writeOffFilePath);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    qDebug() << "Error opening write-off file for append:" << writeOffFilePath;
+    return false;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_6_0);
+  for (const auto &record : records) {
+    writeWriteOffRecordToFile(out, record);
+  }
+
+  if (out.status() != QDataStream::Ok || !file.flush()) {
+    file.resize(writeOffJournalEnd);
+    return false;
+  }
+  writeOffJournalEnd = file.size();
+  file.close();
+  return true;
+}
+
+bool FileStorageBackend::decodeWriteOff(const QByteArray &payload,
+                                        WriteOffRecord &record) {
+  QDataStream in(payload);
+  in.setVersion(QDataStream::Qt_6_0);
+  return readWriteOffRecordFromFile(in, record);
+}
+
+void FileStorageBackend::writeProductToFile(QDataStream &stream,
+                                            const Product &product) {
+
+  stream << static_cast<qint32>(product.getId());
+
+  QString name = QString::fromStdString(product.getName());
+  stream << name;
+
+  QString category = QString::fromStdString(product.getCategory());
+  stream << category;
+
+  stream << static_cast<qint32>(product.getQuantity());
+
+  stream << product.getUnitPrice();
+
+  QString productType = QString::fromStdString(product.getProductType());
+  stream << productType;
+}
+
+bool FileStorageBackend::readProductFromFile(QDataStream &stream,
+                                             Product &product) {
+  if (stream.atEnd()) {
+    return false;
+  }
+
+  qint32 id;
+  stream >> id;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+
+  QString name;
+  stream >> name;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+
+  QString category;
+  stream >> category;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+
+  qint32 quantity;
+  stream >> quantity;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+
+  double unitPrice;
+  stream >> unitPrice;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+
+  QString productType;
+  stream >> productType;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+
+  product =
+      Product(name.toStdString(), category.toStdString(), quantity, unitPrice);
+  product.setId(id);
+
+  return true;
+}
+
+void FileStorageBackend::writeWriteOffRecordToFile(
+    QDataStream &stream, const WriteOffRecord &record) {
+
+  stream << static_cast<qint32>(record.id);
+
+  stream << static_cast<qint32>(record.productId);
+
+  QString name = QString::fromStdString(record.productName);
+  stream << name;
+
+  stream << static_cast<qint32>(record.quantity);
+
+  stream << record.value;
+
+  stream << record.reason;
+}
+
+bool FileStorageBackend::readWriteOffRecordFromFile(QDataStream &stream,
+                                                    WriteOffRecord &record) {
+  if (stream.atEnd()) {
+    return false;
+  }
+
+  qint32 id;
+  stream >> id;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+  record.id = id;
+
+  qint32 productId;
+  stream >> productId;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+  record.productId = productId;
+
+  QString name;
+  stream >> name;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+  record.productName = name.toStdString();
+
+  qint32 quantity;
+  stream >> quantity;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+  record.quantity = quantity;
+
+  double value;
+  stream >> value;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+  record.value = value;
+
+  QString reason;
+  stream >> reason;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+  record.reason = reason;
+
+  return true;
+}
+
+bool FileStorageBackend::addProduct(const Product &product) {
+  auto storeLock = lockStore(Store::Products, StoreLock::Mode::Exclusive);
+  std::lock_guard<std::mutex> lock(productLogMutex);
+  bool resident = ensureProductsResident();
+  if (!appendProductRecord(RecordLog::Op::Upsert, product.getId(),
+                           encodeProduct(product))) {
+    return false;
+  }
+
+  if (resident) {
+    upsertResident(productCache, productSlots, product);
+    productStamp = stampOf(dataFilePath);
+  }
+  return true;
+}
+
+bool FileStorageBackend::updateProduct(const Product &product) {
+  auto storeLock = lockStore(Store::Products, StoreLock::Mode::Exclusive);
+  std::lock_guard<std::mutex> lock(productLogMutex);
+  bool resident = ensureProductsResident();
+  if (!productExists(product.getId())) {
+    qDebug() << "Product with ID" << product.getId()
+             << "not found in database for update";
+    return false;
+  }
+
+  if (!appendProductRecord(RecordLog::Op::Upsert, product.getId(),
+                           encodeProduct(product))) {
+    qDebug() << "Failed to save products after update";
+    return false;
+  }
+
+  if (resident) {
+    upsertResident(productCache, productSlots, product);
+    productStamp = stampOf(dataFilePath);
+  }
+  return true;
+}
+
+bool FileStorageBackend::deleteProduct(int id) {
+  auto storeLock = lockStore(Store::Products, StoreLock::Mode::Exclusive);
+  std::lock_guard<std::mutex> lock(productLogMutex);
+  bool resident = ensureProductsResident();
+  if (!productExists(id)) {
+    return false;
+  }
+
+  if (!appendProductRecord(RecordLog::Op::Tombstone, id, QByteArray())) {
+    return false;
+  }
+
+  if (resident) {
+    eraseResident(productCache, productSlots, id);
+    productStamp = stampOf(dataFilePath);
+  }
+  return true;
+}
+
+std::vector<bool>
+FileStorageBackend::addProducts(std::span<const Product> products) {
+  return writeProducts(products, false);
+}
+
+std::vector<bool>
+FileStorageBackend::updateProducts(std::span<const Product> products) {
+  return writeProducts(products, true);
+}
+
+std::vector<bool>
+FileStorageBackend::writeProducts(std::span<const Product> products,
+                                  bool existingOnly) {
+  auto storeLock = lockStore(Store::Products, StoreLock::Mode::Exclusive);
+  std::vector<bool> results(products.size(), false);
+
+  std::lock_guard<std::mutex> lock(productLogMutex);
+  bool resident = ensureProductsResident();
+
+  // Repeated ids collapse onto their last occurrence, so each product is
+  // written once per batch.
+  std::map<int, size_t> latest;
+  for (size_t i = 0; i < products.size(); ++i) {
+    int id = products[i].getId();
+    if (!existingOnly || productExists(id)) {
+      latest[id] = i;
+    }
+  }
+  if (latest.empty()) {
+    return results;
+  }
+
+  std::vector<RecordLog::Record> records;
+  records.reserve(latest.size());
+  for (const auto &entry : latest) {
+    RecordLog::Record record;
+    record.op = RecordLog::Op::Upsert;
+    record.key = entry.first;
+    record.payload = encodeProduct(products[entry.second]);
+    records.push_back(record);
+  }
+
+  if (!productLog->append(records)) {
+    return results;
+  }
+  commitWrite(Store::Products, dataFilePath);
+
+  for (const auto &record : records) {
+    applyProductRecord(productOffsets, record, productLogRecords);
+  }
+  scheduleProductCompaction();
+
+  if (resident) {
+    for (const auto &entry : latest) {
+      upsertResident(productCache, productSlots, products[entry.second]);
+    }
+    productStamp = stampOf(dataFilePath);
+  }
+
+  for (size_t i = 0; i < products.size(); ++i) {
+    results[i] = latest.count(products[i].getId()) > 0;
+  }
+  return results;
+}
+
+Product FileStorageBackend::getProduct(int id) {
+  auto storeLock = lockStore(Store::Products, StoreLock::Mode::Shared);
+  if (residentForRead(Store::Products)) {
+    auto it = productSlots.constFind(id);
+    return it != productSlots.constEnd() ? productCache[it.value()]
+                                         : Product();
+  }
+
+  qint64 offset = productOffsets.value(id, PRODUCT_NOT_IN_LOG);
+  if (offset == PRODUCT_NOT_IN_LOG) {
+    int row = productColumns->findRow(id);
+    return row >= 0 ? productFromColumns(row) : Product();
+  }
+  if (offset == PRODUCT_DELETED) {
+    return Product();
+  }
+
+  RecordLog::Record record;
+  Product product;
+  if (!productLog->readAt(offset, record) ||
+      !decodeProduct(record.payload, product)) {
+    return Product();
+  }
+
+  return product;
+}
+
+std::vector<Product> FileStorageBackend::getAllProducts() {
+  auto storeLock = lockStore(Store::Products, StoreLock::Mode::Shared);
+  std::vector<Product> products;
+  loadProducts(products);
+  return products;
+}
+
+std::vector<Product>
+FileStorageBackend::searchProductsByName(const QString &name) {
+  auto storeLock = lockStore(Store::Products, StoreLock::Mode::Shared);
+  std::vector<Product> results;
+  QString searchName = name.toLower();
+  auto matches = [&searchName](const Product &product) {
+    return QString::fromStdString(product.getName())
+        .toLower()
+        .contains(searchName);
+  };
+  auto collect = [&](const Product &product) {
+    if (matches(product)) {
+      results.push_back(product);
+    }
+  };
+
+  if (residentForRead(Store::Products)) {
+    std::for_each(productCache.begin(), productCache.end(), collect);
+    return results;
+  }
+
+  for (int row = 0; row < productColumns->rowCount(); ++row) {
+    if (isOverriddenRow(row)) {
+      continue;
+    }
+    QString productName =
+        productColumns->textAt(productColumns->nameRefAt(row)).toLower();
+    if (productName.contains(searchName)) {
+      results.push_back(productFromColumns(row));
+    }
+  }
+  if (!scanLogProducts(collect)) {
+    return std::vector<Product>();
+  }
+
+  return results;
+}
+
+std::vector<Product>
+FileStorageBackend::searchProductsByCategory(const QString &category) {
+  auto storeLock = lockStore(Store::Products, StoreLock::Mode::Shared);
+  std::vector<Product> results;
+  QString searchCategory = category.toLower();
+  auto collect = [&](const Product &product) {
+    if (QString::fromStdString(product.getCategory()).toLower() ==
+        searchCategory) {
+      results.push_back(product);
+    }
+  };
+
+  if (residentForRead(Store::Products)) {
+    std::for_each(productCache.begin(), productCache.end(), collect);
+    return results;
+  }
+
+  // Only the rows filed under the category are visited.
+  for (int row : productColumns->rowsInCategory(searchCategory)) {
+    if (!isOverriddenRow(row)) {
+      results.push_back(productFromColumns(row));
+    }
+  }
+  if (!scanLogProducts(collect)) {
+    return std::vector<Product>();
+  }
+
+  return results;
+}
+
+double FileStorageBackend::calculateTotalInventoryValue() {
+  auto storeLock = lockStore(Store::Products, StoreLock::Mode::Shared);
+  double total = 0.0;
+  auto accumulate = [&total](const Product &product) {
+    total += product.calculateTotalValue();
+  };
+
+  if (residentForRead(Store::Products)) {
+    std::for_each(productCache.begin(), productCache.end(), accumulate);
+    return total;
+  }
+
+  for (int row = 0; row < productColumns->rowCount(); ++row) {
+    if (!isOverriddenRow(row)) {
+      total += productColumns->quantityAt(row) * productColumns->priceAt(row);
+    }
+  }
+  scanLogProducts(accumulate);
+  return total;
+}
+
+int FileStorageBackend::getTotalProductQuantity() {
+  auto storeLock = lockStore(Store::Products, StoreLock::Mode::Shared);
+  int total = 0;
+  auto accumulate = [&total](const Product &product) {
+    total += product.getQuantity();
+  };
+
+  if (residentForRead(Store::Products)) {
+    std::for_each(productCache.begin(), productCache.end(), accumulate);
+    return total;
+  }
+
+  for (int row = 0; row < productColumns->rowCount(); ++row) {
+    if (!isOverriddenRow(row)) {
+      total += productColumns->quantityAt(row);
+    }
+  }
+  scanLogProducts(accumulate);
+  return total;
+}
+
+std::vector<bool> FileStorageBackend::addWriteOffRecords(
+    std::span<const WriteOffRecord> records) {
+  auto storeLock = lockStore(Store::WriteOffs, StoreLock::Mode::Exclusive);
+  std::vector<bool> results(records.size(), false);
+  if (records.empty()) {
+    return results;
+  }
+
+  try {
+    // Ids follow on from the journal's last record, which may have been
+    // written by another process since this one last looked.
+    if (writeOffJournalOpen ? !catchUpWriteOffJournal()
+                            : !openWriteOffJournal()) {
+      return results;
+    }
+
+    bool resident = ensureWriteOffsResident();
+    const int firstId = lastWriteOffId + 1;
+
+    std::vector<WriteOffRecord> stored(records.begin(), records.end());
+    for (size_t i = 0; i < stored.size(); ++i) {
+      stored[i].id = firstId + static_cast<int>(i);
+      if (stored[i].reason.isEmpty()) {
+        stored[i].reason = QString("No reason provided");
+      }
+    }
+
+    if (!appendWriteOffRecords(stored)) {
+      writeOffsResident = false;
+      return results;
+    }
+    lastWriteOffId = stored.back().id;
+    commitWrite(Store::WriteOffs, writeOffFilePath);
+
+    if (resident) {
+      writeOffCache.insert(writeOffCache.end(), stored.begin(), stored.end());
+      writeOffStamp = stampOf(writeOffFilePath);
+    }
+    results.assign(records.size(), true);
+    return results;
+  } catch (const std::exception &e) {
+    qDebug() << "Exception in addWriteOffRecords:" << e.what();
+    return results;
+  } catch (...) {
+    qDebug() << "Unknown exception in addWriteOffRecords";
+    return results;
+  }
+}
+
+std::vector<QStringList> FileStorageBackend::getWriteOffHistory() {
+  auto storeLock = lockStore(Store::WriteOffs, StoreLock::Mode::Shared);
+  std::vector<WriteOffRecord> records;
+  if (residentForRead(Store::WriteOffs)) {
+    records = writeOffCache;
+  } else if (!loadWriteOffRecords(records)) {
+    return std::vector<QStringList>();
+  }
+
+  std::sort(records.begin(), records.end(),
+            [](const WriteOffRecord &a, const WriteOffRecord &b) {
+              return a.id > b.id;
+            });
+
+  std::vector<QStringList> history;
+  for (const auto &record : records) {
+    QStringList list;
+    list << QString::number(record.id);
+    list << QString::fromStdString(record.productName);
+    list << QString::number(record.quantity);
+    list << QString::number(record.value, 'f', 2);
+    list << record.reason;
+    history.push_back(list);
+  }
+
+  return history;
+}
+
+QDate FileStorageBackend::stringToDate(const QString &dateString) {
+  return QDate::fromString(dateString, Qt::ISODate);
+}
+
+QString FileStorageBackend::dateToString(const QDate &date) {
+  return date.toString(Qt::ISODate);
+}
+
+bool FileStorageBackend::addOrder(const Order &order) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Exclusive);
+  bool resident = ensureOrdersResident();
+  if (!writeOrder(order)) {
+    return false;
+  }
+
+  if (resident) {
+    upsertResident(orderCache, orderSlots, order);
+    ordersStamp = stampOf(orderIndexFilePath);
+  }
+  return true;
+}
+
+std::vector<bool> FileStorageBackend::addOrders(std::span<const Order> orders) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Exclusive);
+  bool resident = ensureOrdersResident();
+  std::vector<bool> results = writeOrders(orders);
+
+  if (resident) {
+    for (size_t i = 0; i < orders.size(); ++i) {
+      if (results[i]) {
+        upsertResident(orderCache, orderSlots, orders[i]);
+      }
+    }
+    ordersStamp = stampOf(orderIndexFilePath);
+  }
+  return results;
+}
+
+std::vector<Order> FileStorageBackend::getAllOrders() {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Shared);
+  if (residentForRead(Store::Orders)) {
+    std::vector<Order> orders = orderCache;
+    sortById(orders);
+    return orders;
+  }
+
+  std::vector<Order> orders;
+  loadOrders(orders);
+  return orders;
+}
+
+bool FileStorageBackend::forEachOrder(
+    const std::function<void(const Order &)> &visitor) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Shared);
+  return visitOrders(visitor);
+}
+
+std::vector<Order> FileStorageBackend::getOrders(std::vector<int> ids) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Shared);
+  return readOrders(std::move(ids));
+}
+
+std::vector<OrderHeader> FileStorageBackend::getOrderHeaders() {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Shared);
+  std::vector<OrderHeader> headers;
+  headers.reserve(orderIndex.size());
+  auto collect = [&headers](const OrderHeader &header) {
+    headers.push_back(header);
+  };
+
+  if (residentForRead(Store::Orders, false)) {
+    for (const auto &order : orderCache) {
+      collect(headerOf(order));
+    }
+    sortById(headers);
+    return headers;
+  }
+
+  for (const auto &entry : orderSegments) {
+    if (entry.second.liveOrders > 0 &&
+        !scanOrderSegmentHeaders(entry.first, collect)) {
+      return std::vector<OrderHeader>();
+    }
+  }
+
+  sortById(headers);
+  return headers;
+}
+
+std::vector<OrderHeader>
+FileStorageBackend::getOrderHeadersByCompany(const QString &companyName) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Shared);
+  return readOrderHeaders(orderIdsByCompany(companyName));
+}
+
+std::vector<OrderHeader>
+FileStorageBackend::getOrderHeadersByType(OrderType type) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Shared);
+  return readOrderHeaders(orderIdsByType(type));
+}
+
+std::vector<OrderHeader>
+FileStorageBackend::getOrderHeadersByDateRange(const QDate &startDate,
+                                               const QDate &endDate) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Shared);
+  std::vector<OrderHeader> results;
+  auto collect = [&](const OrderHeader &header) {
+    if (header.orderDate >= startDate && header.orderDate <= endDate) {
+      results.push_back(header);
+    }
+  };
+
+  if (residentForRead(Store::Orders, false)) {
+    for (const auto &order : orderCache) {
+      collect(headerOf(order));
+    }
+    sortById(results);
+    return results;
+  }
+
+  for (const auto &entry : orderSegments) {
+    const OrderSegment &stats = entry.second;
+    if (stats.liveOrders == 0 || !stats.minDate.isValid() ||
+        stats.maxDate < startDate || stats.minDate > endDate) {
+      continue;
+    }
+    if (!scanOrderSegmentHeaders(entry.first, collect)) {
+      return std::vector<OrderHeader>();
+    }
+  }
+
+  sortById(results);
+  return results;
+}
+
+std::vector<int>
+FileStorageBackend::orderIdsByCompany(const QString &companyName) const {
+  QString searchName = companyName.toCaseFolded();
+
+  std::vector<int> ids;
+  for (const auto &entry : companyPostings) {
+    if (entry.first.contains(searchName)) {
+      ids.insert(ids.end(), entry.second.begin(), entry.second.end());
+    }
+  }
+  return ids;
+}
+
+std::vector<int> FileStorageBackend::orderIdsByType(OrderType type) const {
+  std::vector<int> ids;
+  auto it = orderTypeBitmaps.constFind(static_cast<int>(type));
+  if (it != orderTypeBitmaps.constEnd()) {
+    for (qsizetype id = 0; id < it->size(); ++id) {
+      if (it->testBit(id)) {
+        ids.push_back(static_cast<int>(id));
+      }
+    }
+  }
+  return ids;
+}
+
+std::vector<Order>
+FileStorageBackend::getOrdersByCompany(const QString &companyName) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Shared);
+  return readOrders(orderIdsByCompany(companyName));
+}
+
+std::vector<Order>
+FileStorageBackend::getOrdersByCompanyPrefix(const QString &prefix) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Shared);
+  QString searchPrefix = prefix.toCaseFolded();
+
+  std::vector<int> ids;
+  for (auto it = companyPostings.lower_bound(searchPrefix);
+       it != companyPostings.end() && it->first.startsWith(searchPrefix);
+       ++it) {
+    ids.insert(ids.end(), it->second.begin(), it->second.end());
+  }
+
+  return readOrders(ids);
+}
+
+std::vector<Order> FileStorageBackend::getOrdersByType(OrderType type) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Shared);
+  return readOrders(orderIdsByType(type));
+}
+
+std::vector<Order> FileStorageBackend::readOrders(std::vector<int> ids) {
+  std::sort(ids.begin(), ids.end());
+
+  std::vector<Order> orders;
+  orders.reserve(ids.size());
+  if (residentForRead(Store::Orders)) {
+    for (int id : ids) {
+      auto it = orderSlots.constFind(id);
+      if (it != orderSlots.constEnd()) {
+        orders.push_back(orderCache[it.value()]);
+      }
+    }
+    return orders;
+  }
+
+  Order order;
+  bool ok = readOrderRecords(ids, [&](int segment, const QByteArray &payload) {
+    if (!decodeOrder(payload, order, &orderDictionary(segment))) {
+      return false;
+    }
+    orders.push_back(order);
+    return true;
+  });
+  if (!ok) {
+    return std::vector<Order>();
+  }
+
+  sortById(orders);
+  return orders;
+}
+
+std::vector<OrderHeader>
+FileStorageBackend::readOrderHeaders(std::vector<int> ids) {
+  std::sort(ids.begin(), ids.end());
+
+  std::vector<OrderHeader> headers;
+  headers.reserve(ids.size());
+  if (residentForRead(Store::Orders, false)) {
+    for (int id : ids) {
+      auto it = orderSlots.constFind(id);
+      if (it != orderSlots.constEnd()) {
+        headers.push_back(headerOf(orderCache[it.value()]));
+      }
+    }
+    return headers;
+  }
+
+  OrderHeader header;
+  bool ok = readOrderRecords(ids, [&](int, const QByteArray &payload) {
+    if (!decodeOrderHeader(payload, header)) {
+      return false;
+    }
+    headers.push_back(header);
+    return true;
+  });
+  if (!ok) {
+    return std::vector<OrderHeader>();
+  }
+
+  sortById(headers);
+  return headers;
+}
+
+bool FileStorageBackend::readOrderRecords(
+    const std::vector<int> &ids,
+    const std::function<bool(int, const QByteArray &)> &visitor) {
+  // Visit records in file order so each segment is read front to back once.
+  std::vector<std::pair<int, qint64>> locations;
+  locations.reserve(ids.size());
+  for (int id : ids) {
+    auto it = orderIndex.constFind(id);
+    if (it != orderIndex.constEnd()) {
+      locations.emplace_back(it->segment, it->offset);
+    }
+  }
+  std::sort(locations.begin(), locations.end());
+
+  QFile file;
+  QDataStream in;
+  in.setVersion(QDataStream::Qt_6_0);
+  int openSegment = -1;
+  quint32 segmentVersion = 0;
+  RecordLog::Record record;
+  for (const auto &location : locations) {
+    if (location.first != openSegment || !file.isOpen()) {
+      file.close();
+      file.setFileName(orderSegmentPath(location.first));
+      if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Error opening orders segment:" << file.fileName();
+        return false;
+      }
+      in.setDevice(&file);
+      segmentVersion = RecordLog::readVersion(in);
+      openSegment = location.first;
+    }
+
+    if (!file.seek(location.second) ||
+        !RecordLog::readRecord(in, record, segmentVersion) ||
+        !visitor(location.first, record.payload)) {
+      qDebug() << "Error reading order record:" << file.fileName();
+      file.close();
+      return false;
+    }
+  }
+  file.close();
+  return true;
+}
+
+std::vector<Order>
+FileStorageBackend::getOrdersByDateRange(const QDate &startDate,
+                                         const QDate &endDate) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Shared);
+  std::vector<Order> results;
+  auto collect = [&](const Order &order) {
+    QDate orderDate = order.getOrderDate();
+    if (orderDate >= startDate && orderDate <= endDate) {
+      results.push_back(order);
+    }
+  };
+
+  if (residentForRead(Store::Orders)) {
+    std::for_each(orderCache.begin(), orderCache.end(), collect);
+    sortById(results);
+    return results;
+  }
+
+  for (const auto &entry : orderSegments) {
+    const OrderSegment &stats = entry.second;
+    if (stats.liveOrders == 0 || !stats.minDate.isValid() ||
+        stats.maxDate < startDate || stats.minDate > endDate) {
+      continue;
+    }
+    if (!scanOrderSegment(entry.first, collect)) {
+      return std::vector<Order>();
+    }
+  }
+
+  sortById(results);
+  return results;
+}
+
+bool FileStorageBackend::updateOrder(const Order &order) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Exclusive);
+  bool resident = ensureOrdersResident();
+  if (!orderIndex.contains(order.getId())) {
+    return false;
+  }
+
+  if (!writeOrder(order)) {
+    return false;
+  }
+
+  if (resident) {
+    upsertResident(orderCache, orderSlots, order);
+    ordersStamp = stampOf(orderIndexFilePath);
+  }
+  return true;
+}
+
+bool FileStorageBackend::deleteOrder(int id) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Exclusive);
+  bool resident = ensureOrdersResident();
+  auto it = orderIndex.constFind(id);
+  if (it == orderIndex.constEnd()) {
+    return false;
+  }
+
+  const int segment = it->segment;
+  if (!appendOrderRecord(RecordLog::Op::Tombstone, id, segment, QByteArray())) {
+    return false;
+  }
+
+  OrderSegment &stats = orderSegments[segment];
+  stats.liveOrders--;
+  stats.deadRecords += 2;
+  touchOrderManifest();
+
+  if (resident) {
+    eraseResident(orderCache, orderSlots, id);
+    ordersStamp = stampOf(orderIndexFilePath);
+  }
+  return true;
+}
+
+Order FileStorageBackend::getOrder(int id) {
+  auto storeLock = lockStore(Store::Orders, StoreLock::Mode::Shared);
+  if (residentForRead(Store::Orders)) {
+    auto it = orderSlots.constFind(id);
+    if (it != orderSlots.constEnd()) {
+      return orderCache[it.value()];
+    }
+    return Order();
+  }
+
+  auto it = orderIndex.constFind(id);
+  if (it == orderIndex.constEnd()) {
+    return Order();
+  }
+
+  RecordLog::Record record;
+  Order order;
+  RecordLog log(orderSegmentPath(it->segment), ORDER_LOG_MAGIC);
+  if (!log.readAt(it->offset, record) ||
+      !decodeOrder(record.payload, order, &orderDictionary(it->segment))) {
+    return Order();
+  }
+
+  return order;
+}
+
+bool FileStorageBackend::loadOrders(std::vector<Order> &orders) {
+  orders.clear();
+  orders.reserve(orderIndex.size());
+
+  bool ok = true;
+  for (const auto &entry : orderSegments) {
+    ok = scanOrderSegment(
+             entry.first,
+             [&orders](const Order &order) { orders.push_back(order); }) &&
+         ok;
+  }
+
+  sortById(orders);
+
+  return ok;
+}
+
+bool FileStorageBackend::scanOrderSegment(
+    int segment, const std::function<void(const Order &)> &visitor) {
+  Order order;
+  const OrderDictionary &dictionary = orderDictionary(segment);
+  return scanLiveOrderRecords(segment, [&](const QByteArray &payload) {
+    if (decodeOrder(payload, order, &dictionary)) {
+      visitor(order);
+    }
+  });
+}
+
+bool FileStorageBackend::scanOrderSegmentHeaders(
+    int segment, const std::function<void(const OrderHeader &)> &visitor) {
+  OrderHeader header;
+  return scanLiveOrderRecords(segment, [&](const QByteArray &payload) {
+    if (decodeOrderHeader(payload, header)) {
+      visitor(header);
+    }
+  });
+}
+
+bool FileStorageBackend::scanLiveOrderRecords(
+    int segment, const std::function<void(const QByteArray &)> &visitor) {
+  RecordLog log(orderSegmentPath(segment), ORDER_LOG_MAGIC);
+  return log.scan([&](const RecordLog::Record &record) {
+    auto it = orderIndex.constFind(record.key);
+    if (record.op != RecordLog::Op::Upsert || it == orderIndex.constEnd() ||
+        it->segment != segment || it->offset != record.offset) {
+      return;
+    }
+    visitor(record.payload);
+  });
+}
+
+bool FileStorageBackend::saveOrderSegment(int segment,
+                                          const std::vector<Order> &orders) {
+  QString path = orderSegmentPath(segment);
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qDebug() << "Error opening orders segment for writing:" << path;
+    return false;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_6_0);
+
+  RecordLog(path, ORDER_LOG_MAGIC).writeHeader(out);
+
+  RecordLog::Record record;
+  for (const auto &order : orders) {
+    record.key = order.getId();
+    record.payload = encodeOrder(order, segment);
+    RecordLog::writeRecord(out, record);
+  }
+
+  if (out.status() != QDataStream::Ok || !persistOrderDictionary(segment)) {
+    file.cancelWriting();
+    return false;
+  }
+  return FileSync::commit(file);
+}
+
+QString FileStorageBackend::orderSegmentPath(int segment) const {
+  return QString("%1/orders-%2.dat")
+      .arg(ordersDirPath)
+      .arg(segment, 6, 10, QChar('0'));
+}
+
+QString FileStorageBackend::orderDictionaryPath(int segment) const {
+  return QString("%1/orders-%2.dict")
+      .arg(ordersDirPath)
+      .arg(segment, 6, 10, QChar('0'));
+}
+
+FileStorageBackend::OrderDictionary &
+FileStorageBackend::orderDictionary(int segment) {
+  // Readers sharing the store load dictionaries on first use; map nodes
+  // stay put, so the reference outlives the lock.
+  std::lock_guard<std::mutex> lock(orderDictionaryMutex);
+  OrderDictionary &dictionary = orderDictionaries[segment];
+  if (dictionary.loaded) {
+    return dictionary;
+  }
+
+  RecordLog log(orderDictionaryPath(segment), ORDER_DICT_MAGIC);
+  qint64 validEnd = RecordLog::headerSize();
+  bool ordered = true;
+  RecordLog::SkipReport skips;
+  log.scan(
+      [&](const RecordLog::Record &record) {
+        if (!ordered || record.key < dictionary.strings.size()) {
+          ordered = false;
+          return;
+        }
+        // An entry lost to corruption keeps its slot so later refs line up.
+        while (dictionary.strings.size() < record.key) {
+          dictionary.strings.append(QString());
+        }
+        QString text = QString::fromUtf8(record.payload);
+        dictionary.refs.insert(text, static_cast<quint32>(record.key));
+        dictionary.strings.append(text);
+      },
+      -1, &validEnd, &skips);
+  if (!ordered) {
+    qDebug() << "Out of order entries in orders dictionary:" << log.path();
+  }
+  noteSkips(Store::Orders, skips);
+  log.truncate(validEnd);
+
+  dictionary.persisted = dictionary.strings.size();
+  dictionary.loaded = true;
+  return dictionary;
+}
+
+quint32 FileStorageBackend::internOrderString(OrderDictionary &dictionary,
+                                              const QString &text) {
+  auto it = dictionary.refs.constFind(text);
+  if (it != dictionary.refs.constEnd()) {
+    return it.value();
+  }
+
+  quint32 ref = static_cast<quint32>(dictionary.strings.size());
+  dictionary.strings.append(text);
+  dictionary.refs.insert(text, ref);
+  return ref;
+}
+
+bool FileStorageBackend::persistOrderDictionary(int segment) {
+  OrderDictionary &dictionary = orderDictionary(segment);
+  if (dictionary.persisted == dictionary.strings.size()) {
+    return true;
+  }
+
+  std::vector<RecordLog::Record> records;
+  for (qsizetype ref = dictionary.persisted; ref < dictionary.strings.size();
+       ++ref) {
+    RecordLog::Record record;
+    record.key = static_cast<qint32>(ref);
+    record.payload = dictionary.strings[ref].toUtf8();
+    records.push_back(record);
+  }
+
+  // New strings reach the dictionary before any record referring to them.
+  RecordLog log(orderDictionaryPath(segment), ORDER_DICT_MAGIC);
+  if (!log.append(records)) {
+    for (qsizetype ref = dictionary.persisted;
+         ref < dictionary.strings.size(); ++ref) {
+      dictionary.refs.remove(dictionary.strings[ref]);
+    }
+    dictionary.strings.resize(dictionary.persisted);
+    return false;
+  }
+  commitWrite(Store::Orders, log.path());
+
+  dictionary.persisted = dictionary.strings.size();
+  return true;
+}
+
+int FileStorageBackend::orderSegmentKey(const QDate &date) {
+  return date.isValid() ? date.year() * 100 + date.month() : 0;
+}
+
+bool FileStorageBackend::openOrderSegments() {
+  QDir dir;
+  if (!dir.exists(ordersDirPath) && !dir.mkpath(ordersDirPath)) {
+    return false;
+  }
+
+  orderDictionaries.clear();
+  clearLoadReport(Store::Orders);
+  if (QFile::exists(ordersFilePath) && !migrateLegacyOrders()) {
+    return false;
+  }
+
+  if (!loadOrderManifest()) {
+    qDebug() << "Orders manifest is unreadable, rescanning segments:"
+             << orderManifestFilePath;
+    orderSegments.clear();
+  }
+
+  // Segment files are authoritative; the manifest only caches their stats.
+  std::map<int, OrderSegment> segments;
+  const QStringList names =
+      QDir(ordersDirPath).entryList(QStringList() << "orders-*.dat", QDir::Files);
+  for (const QString &name : names) {
+    bool ok = false;
+    int segment = name.mid(7, 6).toInt(&ok);
+    if (!ok || name != QFileInfo(orderSegmentPath(segment)).fileName()) {
+      continue;
+    }
+    auto it = orderSegments.find(segment);
+    segments[segment] = it != orderSegments.end() ? it->second : OrderSegment();
+  }
+  orderSegments = segments;
+
+  if (!loadOrderIndex()) {
+    return false;
+  }
+
+  bool manifestChanged = false;
+  for (const auto &entry : orderSegments) {
+    if (entry.second.size != QFileInfo(orderSegmentPath(entry.first)).size()) {
+      if (!refreshOrderSegmentStats(entry.first)) {
+        return false;
+      }
+      manifestChanged = true;
+    }
+  }
+
+  std::map<int, OrderSegment> before = orderSegments;
+  if (!freezeOrderSegments()) {
+    return false;
+  }
+  for (const auto &entry : orderSegments) {
+    manifestChanged = manifestChanged ||
+                      entry.second.frozen != before[entry.first].frozen;
+  }
+
+  return !manifestChanged || saveOrderManifest();
+}
+
+bool FileStorageBackend::migrateLegacyOrders() {
+  std::map<int, Order> live;
+  RecordLog legacyLog(ordersFilePath, ORDER_LOG_MAGIC);
+
+  if (legacyLog.hasHeader()) {
+    Order order;
+    legacyLog.scan([&](const RecordLog::Record &record) {
+      if (record.op == RecordLog::Op::Tombstone) {
+        live.erase(record.key);
+      } else if (decodeOrder(record.payload, order, nullptr)) {
+        live[record.key] = order;
+      }
+    });
+  } else {
+    QFile file(ordersFilePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+      return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    Order order;
+    while (!in.atEnd()) {
+      if (readOrderFromFile(in, order, nullptr)) {
+        live[order.getId()] = order;
+      } else {
+        break;
+      }
+    }
+    file.close();
+  }
+
+  std::map<int, std::vector<Order>> segments;
+  for (const auto &entry : live) {
+    segments[orderSegmentKey(entry.second.getOrderDate())].push_back(
+        entry.second);
+  }
+
+  qDebug() << "Migrating" << live.size() << "orders into" << segments.size()
+           << "monthly segments:" << ordersDirPath;
+  for (const auto &entry : segments) {
+    if (!saveOrderSegment(entry.first, entry.second)) {
+      return false;
+    }
+  }
+
+  QFile::remove(QFileInfo(ordersFilePath).absolutePath() + "/orders.idx");
+  QFile::remove(orderIndexFilePath);
+  QFile::remove(orderManifestFilePath);
+  return QFile::remove(ordersFilePath);
+}
+
+bool FileStorageBackend::loadOrderManifest() {
+  orderSegments.clear();
+
+  QFile file(orderManifestFilePath);
+  if (!file.exists()) {
+    return true;
+  }
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_6_0);
+
+  quint32 magic = 0;
+  quint32 version = 0;
+  qint32 count = 0;
+  in >> magic >> version >> count;
+  if (in.status() != QDataStream::Ok || magic != ORDER_MANIFEST_MAGIC ||
+      version != ORDER_MANIFEST_VERSION) {
+    file.close();
+    return false;
+  }
+
+  for (qint32 i = 0; i < count; ++i) {
+    qint32 segment;
+    qint32 liveOrders;
+    qint32 deadRecords;
+    OrderSegment stats;
+    in >> segment >> stats.minDate >> stats.maxDate >> liveOrders >>
+        deadRecords >> stats.size >> stats.frozen;
+    if (in.status() != QDataStream::Ok) {
+      file.close();
+      orderSegments.clear();
+      return false;
+    }
+    stats.liveOrders = liveOrders;
+    stats.deadRecords = deadRecords;
+    orderSegments[segment] = stats;
+  }
+
+  file.close();
+  return true;
+}
+
+bool FileStorageBackend::saveOrderManifest() {
+  QSaveFile file(orderManifestFilePath);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qDebug() << "Error opening orders manifest for writing:"
+             << orderManifestFilePath;
+    return false;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_6_0);
+
+  out << ORDER_MANIFEST_MAGIC;
+  out << ORDER_MANIFEST_VERSION;
+  out << static_cast<qint32>(orderSegments.size());
+  for (const auto &entry : orderSegments) {
+    const OrderSegment &stats = entry.second;
+    out << static_cast<qint32>(entry.first);
+    out << stats.minDate << stats.maxDate;
+    out << static_cast<qint32>(stats.liveOrders);
+    out << static_cast<qint32>(stats.deadRecords);
+    out << stats.size;
+    out << stats.frozen;
+  }
+
+  if (out.status() != QDataStream::Ok || !file.commit()) {
+    qDebug() << "Error writing orders manifest:" << orderManifestFilePath;
+    return false;
+  }
+  orderManifestDirty = false;
+  return true;
+}
+
+bool FileStorageBackend::refreshOrderSegmentStats(int segment) {
+  OrderSegment stats;
+  int records = 0;
+  RecordLog log(orderSegmentPath(segment), ORDER_LOG_MAGIC);
+  bool ok = log.scan([&records](const RecordLog::Record &) { records++; });
+  ok = ok && scanOrderSegment(segment, [&stats](const Order &order) {
+         QDate date = order.getOrderDate();
+         if (!stats.minDate.isValid() || date < stats.minDate) {
+           stats.minDate = date;
+         }
+         if (!stats.maxDate.isValid() || date > stats.maxDate) {
+           stats.maxDate = date;
+         }
+         stats.liveOrders++;
+       });
+  if (!ok) {
+    qDebug() << "Error reading orders segment:" << log.path();
+    return false;
+  }
+
+  stats.deadRecords = records - stats.liveOrders;
+  stats.size = log.size();
+  orderSegments[segment] = stats;
+  return true;
+}
+
+bool FileStorageBackend::freezeOrderSegments() {
+  const int currentSegment = orderSegmentKey(QDate::currentDate());
+
+  bool compacted = false;
+  for (auto &entry : orderSegments) {
+    if (entry.first >= currentSegment || entry.second.frozen) {
+      continue;
+    }
+    if (entry.second.deadRecords > 0) {
+      if (!compactOrderSegment(entry.first)) {
+        return false;
+      }
+      compacted = true;
+    }
+    entry.second.frozen = true;
+  }
+
+  return !compacted || saveOrderIndex();
+}
+
+bool FileStorageBackend::compactOrderSegment(int segment) {
+  std::vector<std::pair<qint64, int>> live;
+  for (auto it = orderIndex.constBegin(); it != orderIndex.constEnd(); ++it) {
+    if (it->segment == segment) {
+      live.emplace_back(it->offset, it.key());
+    }
+  }
+  std::sort(live.begin(), live.end());
+
+  RecordLog log(orderSegmentPath(segment), ORDER_LOG_MAGIC);
+  QFile in(log.path());
+  QSaveFile out(log.path());
+  if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly)) {
+    qDebug() << "Error opening orders segment for compaction:" << log.path();
+    return false;
+  }
+
+  QDataStream reader(&in);
+  reader.setVersion(QDataStream::Qt_6_0);
+  quint32 segmentVersion = RecordLog::readVersion(reader);
+  QDataStream writer(&out);
+  writer.setVersion(QDataStream::Qt_6_0);
+
+  log.writeHeader(writer);
+
+  QHash<int, OrderLocation> moved;
+  RecordLog::Record record;
+  for (const auto &entry : live) {
+    if (!in.seek(entry.first) ||
+        !RecordLog::readRecord(reader, record, segmentVersion)) {
+      in.close();
+      out.cancelWriting();
+      qDebug() << "Error reading orders segment:" << log.path();
+      return false;
+    }
+
+    OrderLocation location;
+    location.segment = segment;
+    location.offset = out.pos();
+    RecordLog::writeRecord(writer, record);
+    location.length = out.pos() - location.offset;
+    moved.insert(entry.second, location);
+  }
+  in.close();
+
+  qint64 size = out.pos();
+  if (writer.status() != QDataStream::Ok || !FileSync::commit(out)) {
+    qDebug() << "Error compacting orders segment:" << log.path();
+    return false;
+  }
+
+  for (auto it = moved.constBegin(); it != moved.constEnd(); ++it) {
+    orderIndex[it.key()] = it.value();
+  }
+  OrderSegment &stats = orderSegments[segment];
+  stats.deadRecords = 0;
+  stats.size = size;
+  return true;
+}
+
+bool FileStorageBackend::loadOrderIndex() {
+  clearOrderIndex();
+
+  QFile file(orderIndexFilePath);
+  if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+    return rebuildOrderIndex();
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_6_0);
+
+  quint32 magic = 0;
+  quint32 version = 0;
+  in >> magic >> version;
+  if (in.status() != QDataStream::Ok || magic != ORDER_INDEX_MAGIC ||
+      version != ORDER_INDEX_VERSION) {
+    file.close();
+    return rebuildOrderIndex();
+  }
+
+  QHash<int, qint64> coveredEnd;
+  qint64 validIndexEnd = file.pos();
+  while (!in.atEnd()) {
+    quint8 op;
+    qint32 id;
+    qint32 segment;
+    OrderLocation location;
+    in >> op >> id >> segment >> location.offset >> location.length;
+    OrderKeys keys;
+    if (op == static_cast<quint8>(RecordLog::Op::Upsert)) {
+      qint32 orderType;
+      in >> keys.company >> orderType;
+      keys.type = static_cast<OrderType>(orderType);
+    }
+    if (in.status() != QDataStream::Ok) {
+      break;
+    }
+
+    location.segment = segment;
+    applyOrderIndexEntry(static_cast<RecordLog::Op>(op), id, location, keys);
+    coveredEnd[segment] = std::max(coveredEnd.value(segment),
+                                   location.offset + location.length);
+    validIndexEnd = file.pos();
+  }
+  bool tornTail = file.size() > validIndexEnd;
+  file.close();
+
+  if (tornTail) {
+    QFile::resize(orderIndexFilePath, validIndexEnd);
+  }
+
+  for (auto it = coveredEnd.constBegin(); it != coveredEnd.constEnd(); ++it) {
+    if (orderSegments.find(it.key()) == orderSegments.end() ||
+        it.value() > QFileInfo(orderSegmentPath(it.key())).size()) {
+      qDebug() << "Orders index is stale, rebuilding:" << orderIndexFilePath;
+      return rebuildOrderIndex();
+    }
+  }
+
+  QFile indexFile(orderIndexFilePath);
+  if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    qDebug() << "Error opening orders index for writing:"
+             << orderIndexFilePath;
+    return false;
+  }
+
+  QDataStream out(&indexFile);
+  out.setVersion(QDataStream::Qt_6_0);
+
+  bool ok = true;
+  for (const auto &entry : orderSegments) {
+    qint64 from = coveredEnd.value(entry.first, 0);
+    if (from < QFileInfo(orderSegmentPath(entry.first)).size()) {
+      ok = catchUpOrderSegment(out, entry.first, from) && ok;
+    }
+  }
+
+  indexFile.close();
+  return ok && out.status() == QDataStream::Ok;
+}
+
+bool FileStorageBackend::rebuildOrderIndex() {
+  clearOrderIndex();
+
+  // Replay each segment on its own so a tombstone left behind in an older
+  // month cannot hide the order's current copy in another segment.
+  for (const auto &entry : orderSegments) {
+    QHash<int, OrderLocation> live;
+    QHash<int, OrderKeys> liveKeys;
+    RecordLog log(orderSegmentPath(entry.first), ORDER_LOG_MAGIC);
+    qint64 validEnd = 0;
+    RecordLog::SkipReport skips;
+    bool ok = log.scan(
+        [&](const RecordLog::Record &record) {
+          if (record.op == RecordLog::Op::Upsert) {
+            OrderLocation location;
+            location.segment = entry.first;
+            location.offset = record.offset;
+            location.length = record.length;
+            live[record.key] = location;
+            decodeOrderKeys(record.payload, liveKeys[record.key]);
+          } else {
+            live.remove(record.key);
+            liveKeys.remove(record.key);
+          }
+        },
+        -1, &validEnd, &skips);
+    if (!ok || !log.truncate(validEnd)) {
+      qDebug() << "Error reading orders segment:" << log.path();
+      return false;
+    }
+    noteSkips(Store::Orders, skips);
+
+    for (auto it = live.constBegin(); it != live.constEnd(); ++it) {
+      orderIndex.insert(it.key(), it.value());
+      indexOrderKeys(it.key(), liveKeys.value(it.key()));
+    }
+  }
+
+  return saveOrderIndex();
+}
+
+bool FileStorageBackend::saveOrderIndex() {
+  QSaveFile file(orderIndexFilePath);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qDebug() << "Error opening orders index for writing:"
+             << orderIndexFilePath;
+    return false;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_6_0);
+  out << ORDER_INDEX_MAGIC;
+  out << ORDER_INDEX_VERSION;
+
+  for (auto it = orderIndex.constBegin(); it != orderIndex.constEnd(); ++it) {
+    writeOrderIndexEntry(out, RecordLog::Op::Upsert, it.key(), it.value(),
+                         orderKeys.value(it.key()));
+  }
+
+  if (out.status() != QDataStream::Ok || !file.commit()) {
+    qDebug() << "Error writing orders index:" << orderIndexFilePath;
+    return false;
+  }
+  return true;
+}
+
+bool FileStorageBackend::catchUpOrderSegment(QDataStream &stream, int segment,
+                                             qint64 from) {
+  RecordLog log(orderSegmentPath(segment), ORDER_LOG_MAGIC);
+  qint64 validEnd = 0;
+  RecordLog::SkipReport skips;
+  bool ok = log.scan(
+      [&](const RecordLog::Record &record) {
+        OrderLocation location;
+        location.segment = segment;
+        location.offset = record.offset;
+        location.length = record.length;
+        OrderKeys keys;
+        if (record.op == RecordLog::Op::Upsert) {
+          decodeOrderKeys(record.payload, keys);
+        }
+        writeOrderIndexEntry(stream, record.op, record.key, location, keys);
+        applyOrderIndexEntry(record.op, record.key, location, keys);
+      },
+      from, &validEnd, &skips);
+  if (!ok) {
+    qDebug() << "Error reading orders segment:" << log.path();
+    return false;
+  }
+
+  noteSkips(Store::Orders, skips);
+  return log.truncate(validEnd);
+}
+
+void FileStorageBackend::applyOrderIndexEntry(RecordLog::Op op, int id,
+                                              const OrderLocation &location,
+                                              const OrderKeys &keys) {
+  if (op == RecordLog::Op::Upsert) {
+    orderIndex[id] = location;
+    indexOrderKeys(id, keys);
+    return;
+  }
+
+  auto it = orderIndex.find(id);
+  if (it != orderIndex.end() && it->segment == location.segment) {
+    orderIndex.erase(it);
+    unindexOrderKeys(id);
+  }
+}
+
+void FileStorageBackend::writeOrderIndexEntry(QDataStream &stream,
+                                              RecordLog::Op op, int id,
+                                              const OrderLocation &location,
+                                              const OrderKeys &keys) {
+  stream << static_cast<quint8>(op);
+  stream << static_cast<qint32>(id);
+  stream << static_cast<qint32>(location.segment);
+  stream << location.offset;
+  stream << location.length;
+  if (op == RecordLog::Op::Upsert) {
+    stream << keys.company;
+    stream << static_cast<qint32>(static_cast<int>(keys.type));
+  }
+}
+
+void FileStorageBackend::clearOrderIndex() {
+  orderIndex.clear();
+  orderKeys.clear();
+  companyPostings.clear();
+  orderTypeBitmaps.clear();
+}
+
+void FileStorageBackend::indexOrderKeys(int id, const OrderKeys &keys) {
+  unindexOrderKeys(id);
+  if (id < 0) {
+    return;
+  }
+
+  orderKeys.insert(id, keys);
+  companyPostings[keys.company].insert(id);
+
+  QBitArray &bitmap = orderTypeBitmaps[static_cast<int>(keys.type)];
+  if (bitmap.size() <= id) {
+    bitmap.resize(std::max<qsizetype>(id + 1, bitmap.size() * 2));
+  }
+  bitmap.setBit(id);
+}
+
+void FileStorageBackend::unindexOrderKeys(int id) {
+  auto it = orderKeys.find(id);
+  if (it == orderKeys.end()) {
+    return;
+  }
+
+  auto postings = companyPostings.find(it->company);
+  if (postings != companyPostings.end()) {
+    postings->second.remove(id);
+    if (postings->second.isEmpty()) {
+      companyPostings.erase(postings);
+    }
+  }
+
+  QBitArray &bitmap = orderTypeBitmaps[static_cast<int>(it->type)];
+  if (id < bitmap.size()) {
+    bitmap.clearBit(id);
+  }
+
+  orderKeys.erase(it);
+}
+
+FileStorageBackend::OrderKeys FileStorageBackend::keysOf(const Order &order) {
+  OrderKeys keys;
+  keys.company = order.getCompanyName().toCaseFolded();
+  keys.type = order.getOrderType();
+  return keys;
+}
+
+bool FileStorageBackend::decodeOrderKeys(const QByteArray &payload,
+                                         OrderKeys &keys) {
+  QDataStream in(payload);
+  in.setVersion(QDataStream::Qt_6_0);
+
+  OrderHeader header;
+  qint32 tag = 0;
+  if (!readOrderHeader(in, header, tag)) {
+    return false;
+  }
+
+  keys.company = header.companyName.toCaseFolded();
+  keys.type = header.orderType;
+  return true;
+}
+
+bool FileStorageBackend::appendOrderRecord(RecordLog::Op op, int id,
+                                           int segment,
+                                           const QByteArray &payload,
+                                           const OrderKeys &keys) {
+  RecordLog log(orderSegmentPath(segment), ORDER_LOG_MAGIC);
+  OrderLocation location;
+  location.segment = segment;
+  location.offset = log.append(op, id, payload, &location.length);
+  if (location.offset < 0) {
+    return false;
+  }
+  commitWrite(Store::Orders, log.path());
+  applyOrderIndexEntry(op, id, location, keys);
+
+  OrderSegment &stats = orderSegments[segment];
+  stats.size = location.offset + location.length;
+  stats.frozen = false;
+
+  // A missing entry only makes the index stale; it is caught up on connect().
+  QFile file(orderIndexFilePath);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    qDebug() << "Error appending to orders index:" << orderIndexFilePath;
+    return true;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_6_0);
+  writeOrderIndexEntry(out, op, id, location, keys);
+  file.close();
+  return true;
+}
+
+void FileStorageBackend::touchOrderManifest() {
+  // The manifest only caches segment stats and is rebuilt when it disagrees
+  // with the segments, so outside sync mode it is written on flush().
+  orderManifestDirty = true;
+  if (durability(Store::Orders) == Durability::Sync) {
+    saveOrderManifest();
+  }
+}
+
+bool FileStorageBackend::writeOrder(const Order &order) {
+  return writeOrders(std::span<const Order>(&order, 1)).front();
+}
+
+std::vector<bool>
+FileStorageBackend::writeOrders(std::span<const Order> orders) {
+  std::vector<bool> results(orders.size(), false);
+
+  std::map<int, size_t> latest;
+  for (size_t i = 0; i < orders.size(); ++i) {
+    latest[orders[i].getId()] = i;
+  }
+
+  std::map<int, std::vector<RecordLog::Record>> upserts;
+  std::map<int, std::vector<RecordLog::Record>> retired;
+  for (const auto &entry : latest) {
+    const Order &order = orders[entry.second];
+    const int segment = orderSegmentKey(order.getOrderDate());
+
+    RecordLog::Record record;
+    record.op = RecordLog::Op::Upsert;
+    record.key = entry.first;
+    record.payload = encodeOrder(order, segment);
+    upserts[segment].push_back(record);
+
+    auto it = orderIndex.constFind(entry.first);
+    if (it != orderIndex.constEnd() && it->segment != segment) {
+      RecordLog::Record tombstone;
+      tombstone.op = RecordLog::Op::Tombstone;
+      tombstone.key = entry.first;
+      retired[it->segment].push_back(tombstone);
+    }
+  }
+
+  // A missing entry only makes the index stale; it is caught up on connect().
+  QFile indexFile(orderIndexFilePath);
+  bool indexOpen = indexFile.open(QIODevice::WriteOnly | QIODevice::Append);
+  if (!indexOpen) {
+    qDebug() << "Error appending to orders index:" << orderIndexFilePath;
+  }
+  QDataStream indexOut(&indexFile);
+  indexOut.setVersion(QDataStream::Qt_6_0);
+
+  // New copies are written before the tombstones retiring moved orders, so
+  // a crash in between leaves a duplicate rather than a lost order.
+  QSet<int> written;
+  for (auto &entry : upserts) {
+    RecordLog log(orderSegmentPath(entry.first), ORDER_LOG_MAGIC);
+    if (!persistOrderDictionary(entry.first) || !log.append(entry.second)) {
+      continue;
+    }
+    commitWrite(Store::Orders, log.path());
+
+    OrderSegment &stats = orderSegments[entry.first];
+    for (const auto &record : entry.second) {
+      const Order &order = orders[latest[record.key]];
+      QDate date = order.getOrderDate();
+      if (!stats.minDate.isValid() || date < stats.minDate) {
+        stats.minDate = date;
+      }
+      if (!stats.maxDate.isValid() || date > stats.maxDate) {
+        stats.maxDate = date;
+      }
+
+      auto previous = orderIndex.constFind(record.key);
+      if (previous != orderIndex.constEnd() &&
+          previous->segment == entry.first) {
+        stats.deadRecords++;
+      } else {
+        stats.liveOrders++;
+      }
+
+      OrderLocation location;
+      location.segment = entry.first;
+      location.offset = record.offset;
+      location.length = record.length;
+      OrderKeys keys = keysOf(order);
+      applyOrderIndexEntry(record.op, record.key, location, keys);
+      if (indexOpen) {
+        writeOrderIndexEntry(indexOut, record.op, record.key, location, keys);
+      }
+      written.insert(record.key);
+    }
+    stats.size = entry.second.back().offset + entry.second.back().length;
+    stats.frozen = false;
+  }
+
+  for (auto &entry : retired) {
+    std::vector<RecordLog::Record> tombstones;
+    for (const auto &record : entry.second) {
+      if (written.contains(record.key)) {
+        tombstones.push_back(record);
+      }
+    }
+
+    RecordLog log(orderSegmentPath(entry.first), ORDER_LOG_MAGIC);
+    if (tombstones.empty() || !log.append(tombstones)) {
+      continue;
+    }
+    commitWrite(Store::Orders, log.path());
+
+    OrderSegment &stats = orderSegments[entry.first];
+    for (const auto &record : tombstones) {
+      OrderLocation location;
+      location.segment = entry.first;
+      location.offset = record.offset;
+      location.length = record.length;
+      applyOrderIndexEntry(record.op, record.key, location, OrderKeys());
+      if (indexOpen) {
+        writeOrderIndexEntry(indexOut, record.op, record.key, location,
+                             OrderKeys());
+      }
+      stats.liveOrders--;
+      stats.deadRecords += 2;
+    }
+    stats.size = tombstones.back().offset + tombstones.back().length;
+    stats.frozen = false;
+  }
+  indexFile.close();
+
+  if (!written.isEmpty()) {
+    touchOrderManifest();
+  }
+
+  for (size_t i = 0; i < orders.size(); ++i) {
+    results[i] = written.contains(orders[i].getId());
+  }
+  return results;
+}
+
+QByteArray FileStorageBackend::encodeOrder(const Order &order, int segment) {
+  QByteArray payload;
+  QDataStream out(&payload, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_6_0);
+  writeOrderToFile(out, order, orderDictionary(segment));
+  return payload;
+}
+
+bool FileStorageBackend::decodeOrder(const QByteArray &payload, Order &order,
+                                     const OrderDictionary *dictionary) {
+  QDataStream in(payload);
+  in.setVersion(QDataStream::Qt_6_0);
+  return readOrderFromFile(in, order, dictionary);
+}
+
+bool FileStorageBackend::decodeOrderHeader(const QByteArray &payload,
+                                           OrderHeader &header) {
+  QDataStream in(payload);
+  in.setVersion(QDataStream::Qt_6_0);
+
+  qint32 tag = 0;
+  if (!readOrderHeader(in, header, tag)) {
+    return false;
+  }
+  if (tag != 0) {
+    return true;
+  }
+
+  // Legacy records keep their totals behind the items.
+  Order order;
+  if (!decodeOrder(payload, order, nullptr)) {
+    return false;
+  }
+  header = headerOf(order);
+  return true;
+}
+
+OrderHeader FileStorageBackend::headerOf(const Order &order) {
+  return OrderHeader(order);
+}
+
+void FileStorageBackend::writeOrderToFile(QDataStream &stream,
+                                          const Order &order,
+                                          OrderDictionary &dictionary) {
+  const auto &items = order.getItems();
+
+  QByteArray itemBlock;
+  QDataStream itemsOut(&itemBlock, QIODevice::WriteOnly);
+  itemsOut.setVersion(QDataStream::Qt_6_0);
+  for (const auto &item : items) {
+    itemsOut << static_cast<qint32>(item.productId);
+    itemsOut << internOrderString(dictionary, item.productName);
+    itemsOut << internOrderString(dictionary, item.category);
+    itemsOut << static_cast<qint32>(item.quantity);
+    itemsOut << item.unitPrice;
+    itemsOut << item.discountPercent;
+    itemsOut << item.totalPrice;
+  }
+
+  stream << ORDER_RECORD_DICT_TAG;
+  stream << static_cast<qint32>(order.getId());
+
+  stream << order.getCompanyName();
+  stream << order.getContactPerson();
+  stream << order.getPhone();
+
+  stream << static_cast<qint32>(static_cast<int>(order.getOrderType()));
+
+  stream << order.getOrderDate();
+
+  stream << static_cast<qint32>(items.size());
+  stream << order.getTotalAmount();
+  stream << order.getTotalDiscount();
+
+  stream << itemBlock;
+}
+
+bool FileStorageBackend::readOrderHeader(QDataStream &stream,
+                                         OrderHeader &header, qint32 &tag) {
+  if (stream.atEnd()) {
+    return false;
+  }
+
+  qint32 first;
+  stream >> first;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+
+  if (first < 0 && first != ORDER_RECORD_TAG &&
+      first != ORDER_RECORD_DICT_TAG)
+    return false;
+  tag = first < 0 ? first : 0;
+  qint32 id = first;
+  if (tag != 0) {
+    stream >> id;
+    if (stream.status() != QDataStream::Ok)
+      return false;
+  }
+  header.id = id;
+
+  stream >> header.companyName;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+  stream >> header.contactPerson;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+  stream >> header.phone;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+
+  qint32 orderTypeInt;
+  stream >> orderTypeInt;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+  header.orderType = static_cast<OrderType>(orderTypeInt);
+
+  stream >> header.orderDate;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+
+  qint32 itemsCount;
+  stream >> itemsCount;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+  header.itemCount = itemsCount;
+
+  header.totalAmount = 0.0;
+  header.totalDiscount = 0.0;
+  if (tag != 0) {
+    stream >> header.totalAmount;
+    if (stream.status() != QDataStream::Ok)
+      return false;
+    stream >> header.totalDiscount;
+    if (stream.status() != QDataStream::Ok)
+      return false;
+  }
+
+  return true;
+}
+
+bool FileStorageBackend::readOrderFromFile(QDataStream &stream, Order &order,
+                                           const OrderDictionary *dictionary) {
+  OrderHeader header;
+  qint32 tag = 0;
+  if (!readOrderHeader(stream, header, tag)) {
+    return false;
+  }
+
+  // Fields are assigned in place so a caller decoding many records into one
+  // Order keeps its item buffer.
+  order.id = header.id;
+  order.companyName = header.companyName;
+  order.contactPerson = header.contactPerson;
+  order.phone = header.phone;
+  order.orderType = header.orderType;
+  order.orderDate = header.orderDate;
+  order.clearItems();
+
+  if (tag != 0) {
+    QByteArray itemBlock;
+    stream >> itemBlock;
+    if (stream.status() != QDataStream::Ok)
+      return false;
+    if (tag == ORDER_RECORD_DICT_TAG && !dictionary)
+      return false;
+
+    QDataStream itemsIn(itemBlock);
+    itemsIn.setVersion(QDataStream::Qt_6_0);
+    return readOrderItems(itemsIn, order, header.itemCount,
+                          tag == ORDER_RECORD_DICT_TAG ? dictionary : nullptr);
+  }
+
+  if (!readOrderItems(stream, order, header.itemCount, nullptr))
+    return false;
+
+  double totalAmount, totalDiscount;
+  stream >> totalAmount;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+  stream >> totalDiscount;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+
+  return true;
+}
+
+bool FileStorageBackend::readOrderItems(QDataStream &stream, Order &order,
+                                        int itemsCount,
+                                        const OrderDictionary *dictionary) {
+  for (int i = 0; i < itemsCount; ++i) {
+    qint32 productId;
+    QString productName, category;
+    qint32 quantity;
+    double unitPrice, discountPercent, totalPrice;
+
+    stream >> productId;
+    if (stream.status() != QDataStream::Ok)
+      return false;
+    if (dictionary) {
+      quint32 nameRef, categoryRef;
+      stream >> nameRef >> categoryRef;
+      if (stream.status() != QDataStream::Ok ||
+          nameRef >= static_cast<quint32>(dictionary->strings.size()) ||
+          categoryRef >= static_cast<quint32>(dictionary->strings.size()))
+        return false;
+      // Shares the dictionary's string data instead of allocating a copy.
+      productName = dictionary->strings[nameRef];
+      category = dictionary->strings[categoryRef];
+    } else {
+      stream >> productName;
+      if (stream.status() != QDataStream::Ok)
+        return false;
+      stream >> category;
+      if (stream.status() != QDataStream::Ok)
+        return false;
+    }
+    stream >> quantity;
+    if (stream.status() != QDataStream::Ok)
+      return false;
+    stream >> unitPrice;
+    if (stream.status() != QDataStream::Ok)
+      return false;
+    stream >> discountPercent;
+    if (stream.status() != QDataStream::Ok)
+      return false;
+    stream >> totalPrice;
+    if (stream.status() != QDataStream::Ok)
+      return false;
+
+    OrderItem item(productId, productName, category, quantity, unitPrice);
+    item.discountPercent = discountPercent;
+    item.totalPrice = totalPrice;
+    order.addItem(item);
+  }
+
+  return true;
+}
@@ -0,0 +1,70 @@
+#include "managers/FileSync.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QtGlobal>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+bool FileSync::syncFile(QFileDevice &file) {
+  if (!file.flush()) {
+    return false;
+  }
+
+#ifdef Q_OS_WIN
+  return _commit(file.handle()) == 0;
+#else
+  return ::fsync(file.handle()) == 0;
+#endif
+}
+
+bool FileSync::syncPath(const QString &filePath) {
+  QFile file(filePath);
+  if (!file.exists()) {
+    return true;
+  }
+
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    qDebug() << "Cannot open file for sync:" << filePath;
+    return false;
+  }
+
+  bool ok = syncFile(file);
+  file.close();
+  if (!ok) {
+    qDebug() << "Error syncing file:" << filePath;
+  }
+  return ok;
+}
+
+bool FileSync::syncDirectory(const QString &dirPath) {
+#ifdef Q_OS_WIN
+  // NTFS journals the rename itself; directories cannot be flushed here.
+  Q_UNUSED(dirPath);
+  return true;
+#else
+  int fd = ::open(QFile::encodeName(dirPath).constData(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = ::fsync(fd) == 0;
+  ::close(fd);
+  return ok;
+#endif
+}
+
+bool FileSync::commit(QSaveFile &file) {
+  // QSaveFile flushes and syncs the temporary file before renaming it over
+  // the target; syncing the directory makes the rename itself durable.
+  if (!file.commit()) {
+    qDebug() << "Error committing file:" << file.fileName();
+    return false;
+  }
+
+  return syncDirectory(QFileInfo(file.fileName()).absolutePath());
+}
@@ -0,0 +1,93 @@
+#include "managers/GroupCommit.h"
+#include "managers/FileSync.h"
+#include <chrono>
+
+GroupCommit::GroupCommit(int windowMs)
+    : windowMs(windowMs), groupDone(group.get_future().share()),
+      syncing(false), stopping(false), worker(&GroupCommit::run, this) {}
+
+GroupCommit::~GroupCommit() {
+  flush();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  worker.join();
+}
+
+std::shared_future<bool> GroupCommit::schedule(const QString &filePath) {
+  std::shared_future<bool> done;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    scheduled.insert(filePath);
+    done = groupDone;
+  }
+  wake.notify_all();
+  return done;
+}
+
+void GroupCommit::defer(const QString &filePath) {
+  std::lock_guard<std::mutex> lock(mutex);
+  deferred.insert(filePath);
+}
+
+bool GroupCommit::flush() {
+  QSet<QString> paths;
+  std::promise<bool> done;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return !syncing; });
+    paths = scheduled;
+    paths.unite(deferred);
+    scheduled.clear();
+    deferred.clear();
+    done = takeGroup();
+  }
+  bool ok = syncAll(paths);
+  done.set_value(ok);
+  return ok;
+}
+
+void GroupCommit::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    wake.wait(lock, [this] { return stopping || !scheduled.isEmpty(); });
+    if (stopping && scheduled.isEmpty()) {
+      return;
+    }
+
+    // Writes arriving during the window share this group's fsync.
+    wake.wait_for(lock, std::chrono::milliseconds(windowMs),
+                  [this] { return stopping; });
+
+    QSet<QString> paths;
+    paths.swap(scheduled);
+    std::promise<bool> done = takeGroup();
+    syncing = true;
+    lock.unlock();
+
+    done.set_value(syncAll(paths));
+
+    lock.lock();
+    syncing = false;
+    idle.notify_all();
+  }
+}
+
+// Hands over the promise of the group being collected and starts the next
+// one. Called with the mutex held.
+std::promise<bool> GroupCommit::takeGroup() {
+  std::promise<bool> done = std::move(group);
+  group = std::promise<bool>();
+  groupDone = group.get_future().share();
+  return done;
+}
+
+bool GroupCommit::syncAll(const QSet<QString> &paths) {
+  bool ok = true;
+  for (const QString &path : paths) {
+    ok = FileSync::syncPath(path) && ok;
+  }
+  return ok;
+}
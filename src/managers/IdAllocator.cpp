@@ -0,0 +1,81 @@
+#include "managers/IdAllocator.h"
+#include "managers/StoreLock.h"
+#include <QDebug>
+#include <algorithm>
+
+IdAllocator::IdAllocator(const QString &filePath, int blockSize,
+                         std::function<int()> highestUsedId)
+    : sequence(filePath), highestUsedId(std::move(highestUsedId)),
+      lockFilePath(filePath + ".lock"), blockSize(blockSize), nextFree(1),
+      blockEnd(0) {}
+
+int IdAllocator::next() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (nextFree > blockEnd) {
+    int first = claim(blockSize);
+    if (first < 0) {
+      return -1;
+    }
+    nextFree = first;
+    blockEnd = first + blockSize - 1;
+  }
+  return nextFree++;
+}
+
+int IdAllocator::reserve(int count) {
+  if (count <= 0) {
+    return -1;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (blockEnd - nextFree + 1 >= count) {
+    int first = nextFree;
+    nextFree += count;
+    return first;
+  }
+  return claim(count);
+}
+
+bool IdAllocator::advancePast(int id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (id <= blockEnd) {
+    nextFree = std::max(nextFree, id + 1);
+    return true;
+  }
+
+  StoreLock fileLock(lockFilePath, StoreLock::Mode::Exclusive);
+  if (!fileLock.isLocked() || !loadSequence() || !sequence.advanceTo(id)) {
+    qDebug() << "Cannot advance id sequence:" << sequence.path();
+    return false;
+  }
+  nextFree = blockEnd + 1;
+  return true;
+}
+
+// The file is re-read under the lock, since other processes claim from it
+// too. The sequence is durable before any claimed id is handed out.
+int IdAllocator::claim(int count) {
+  StoreLock fileLock(lockFilePath, StoreLock::Mode::Exclusive);
+  if (!fileLock.isLocked() || !loadSequence()) {
+    qDebug() << "Cannot read id sequence:" << sequence.path();
+    return -1;
+  }
+
+  int first = sequence.current() + 1;
+  if (!sequence.advanceTo(first + count - 1)) {
+    qDebug() << "Cannot claim ids from sequence:" << sequence.path();
+    return -1;
+  }
+  return first;
+}
+
+// Starting again above the highest stored id can reissue ids that were
+// claimed but never stored, or that belonged to deleted records; the
+// alternative is never handing out another id.
+bool IdAllocator::loadSequence() {
+  if (sequence.load()) {
+    return true;
+  }
+  qDebug() << "Reseeding unreadable id sequence:" << sequence.path();
+  return sequence.reseed(highestUsedId());
+}
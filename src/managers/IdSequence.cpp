@@ -0,0 +1,110 @@
+#include "managers/IdSequence.h"
+#include "managers/FileSync.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QIODevice>
+#include <QSaveFile>
+
+static const quint32 SEQUENCE_MAGIC = 0x53455131;
+
+IdSequence::IdSequence(const QString &filePath)
+    : filePath(filePath), lastId(0), loaded(false) {}
+
+bool IdSequence::exists() const { return QFile::exists(filePath); }
+
+bool IdSequence::load() {
+  lastId = 0;
+  loaded = false;
+
+  QFile file(filePath);
+  if (!file.exists()) {
+    loaded = true;
+    return true;
+  }
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    qDebug() << "Cannot open id sequence:" << filePath;
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_6_0);
+
+  quint32 magic = 0;
+  qint32 value = 0;
+  in >> magic >> value;
+  file.close();
+
+  if (in.status() != QDataStream::Ok || magic != SEQUENCE_MAGIC ||
+      value < 0) {
+    qDebug() << "Ignoring corrupt id sequence:" << filePath;
+    return false;
+  }
+
+  lastId = value;
+  loaded = true;
+  return true;
+}
+
+int IdSequence::next() {
+  if (!loaded && !load()) {
+    return -1;
+  }
+
+  int id = lastId + 1;
+  if (!persist(id)) {
+    return -1;
+  }
+
+  lastId = id;
+  return id;
+}
+
+bool IdSequence::advanceTo(int id) {
+  if (!loaded && !load()) {
+    return false;
+  }
+
+  if (id <= lastId) {
+    return true;
+  }
+
+  if (!persist(id)) {
+    return false;
+  }
+
+  lastId = id;
+  return true;
+}
+
+bool IdSequence::reseed(int id) {
+  if (id < 0 || !persist(id)) {
+    return false;
+  }
+
+  lastId = id;
+  loaded = true;
+  return true;
+}
+
+// The file is replaced whole, so a crash leaves either the old value or the
+// new one, and it is durable once this returns.
+bool IdSequence::persist(int value) {
+  QSaveFile file(filePath);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qDebug() << "Cannot write id sequence:" << filePath;
+    return false;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_6_0);
+  out << SEQUENCE_MAGIC;
+  out << static_cast<qint32>(value);
+
+  if (out.status() != QDataStream::Ok) {
+    file.cancelWriting();
+    return false;
+  }
+  return FileSync::commit(file);
+}
@@ -0,0 +1,234 @@
+#include "managers/ProductColumnFile.h"
+#include <QByteArray>
+#include <QDebug>
+#include <QHash>
+#include <QtEndian>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+static const quint32 COLUMN_FILE_MAGIC = 0x50434F4C;
+static const quint32 COLUMN_FILE_VERSION = 1;
+static const qint64 COLUMN_HEADER_SIZE = 16;
+static const qint64 COLUMN_ROW_WIDTH = 8 + 4 * 4;
+
+ProductColumnFile::ProductColumnFile(const QString &filePath)
+    : filePath(filePath), file(filePath), data(nullptr), dataSize(0), rows(0),
+      heapSize(0), pricesOffset(0), idsOffset(0), quantitiesOffset(0),
+      nameRefsOffset(0), categoryRefsOffset(0), heapOffset(0),
+      categoryRowsBuilt(false) {}
+
+ProductColumnFile::~ProductColumnFile() { close(); }
+
+bool ProductColumnFile::open() {
+  close();
+
+  if (!file.exists() || file.size() == 0) {
+    return true;
+  }
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    qDebug() << "Cannot open product column file:" << filePath;
+    return false;
+  }
+
+  dataSize = file.size();
+  if (dataSize < COLUMN_HEADER_SIZE) {
+    qDebug() << "Product column file is truncated:" << filePath;
+    close();
+    return false;
+  }
+
+  data = file.map(0, dataSize);
+  if (!data) {
+    qDebug() << "Cannot map product column file:" << filePath;
+    close();
+    return false;
+  }
+
+  quint32 magic = qFromLittleEndian<quint32>(data);
+  quint32 version = qFromLittleEndian<quint32>(data + 4);
+  quint32 rowTotal = qFromLittleEndian<quint32>(data + 8);
+  quint32 heapTotal = qFromLittleEndian<quint32>(data + 12);
+  if (magic != COLUMN_FILE_MAGIC || version != COLUMN_FILE_VERSION ||
+      COLUMN_HEADER_SIZE + COLUMN_ROW_WIDTH * rowTotal + heapTotal !=
+          dataSize) {
+    qDebug() << "Invalid product column file:" << filePath;
+    close();
+    return false;
+  }
+
+  rows = rowTotal;
+  heapSize = heapTotal;
+  pricesOffset = COLUMN_HEADER_SIZE;
+  idsOffset = pricesOffset + 8 * static_cast<qint64>(rows);
+  quantitiesOffset = idsOffset + 4 * static_cast<qint64>(rows);
+  nameRefsOffset = quantitiesOffset + 4 * static_cast<qint64>(rows);
+  categoryRefsOffset = nameRefsOffset + 4 * static_cast<qint64>(rows);
+  heapOffset = categoryRefsOffset + 4 * static_cast<qint64>(rows);
+  return true;
+}
+
+void ProductColumnFile::close() {
+  if (data) {
+    file.unmap(data);
+    data = nullptr;
+  }
+  if (file.isOpen()) {
+    file.close();
+  }
+  dataSize = 0;
+  rows = 0;
+  heapSize = 0;
+  categoryRows.clear();
+  categoryRowsBuilt = false;
+}
+
+const uchar *ProductColumnFile::column(qint64 offset, int row,
+                                       int width) const {
+  return data + offset + static_cast<qint64>(row) * width;
+}
+
+int ProductColumnFile::findRow(qint32 id) const {
+  int low = 0;
+  int high = rowCount();
+  while (low < high) {
+    int middle = low + (high - low) / 2;
+    if (idAt(middle) < id) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low < rowCount() && idAt(low) == id ? low : -1;
+}
+
+qint32 ProductColumnFile::idAt(int row) const {
+  return qFromLittleEndian<qint32>(column(idsOffset, row, 4));
+}
+
+qint32 ProductColumnFile::quantityAt(int row) const {
+  return qFromLittleEndian<qint32>(column(quantitiesOffset, row, 4));
+}
+
+double ProductColumnFile::priceAt(int row) const {
+  return std::bit_cast<double>(
+      qFromLittleEndian<quint64>(column(pricesOffset, row, 8)));
+}
+
+quint32 ProductColumnFile::nameRefAt(int row) const {
+  return qFromLittleEndian<quint32>(column(nameRefsOffset, row, 4));
+}
+
+quint32 ProductColumnFile::categoryRefAt(int row) const {
+  return qFromLittleEndian<quint32>(column(categoryRefsOffset, row, 4));
+}
+
+bool ProductColumnFile::heapEntry(quint32 ref, const char *&bytes,
+                                  quint32 &length) const {
+  if (static_cast<qint64>(ref) + 4 > heapSize) {
+    return false;
+  }
+  length = qFromLittleEndian<quint32>(data + heapOffset + ref);
+  if (static_cast<qint64>(ref) + 4 + length > heapSize) {
+    return false;
+  }
+  bytes = reinterpret_cast<const char *>(data + heapOffset + ref + 4);
+  return true;
+}
+
+std::string ProductColumnFile::stringAt(quint32 ref) const {
+  const char *bytes = nullptr;
+  quint32 length = 0;
+  if (!heapEntry(ref, bytes, length)) {
+    return std::string();
+  }
+  return std::string(bytes, length);
+}
+
+QString ProductColumnFile::textAt(quint32 ref) const {
+  const char *bytes = nullptr;
+  quint32 length = 0;
+  if (!heapEntry(ref, bytes, length)) {
+    return QString();
+  }
+  return QString::fromUtf8(bytes, static_cast<qsizetype>(length));
+}
+
+const std::vector<int> &
+ProductColumnFile::rowsInCategory(const QString &category) const {
+  static const std::vector<int> NO_ROWS;
+  std::lock_guard<std::mutex> lock(categoryRowsMutex);
+  if (!categoryRowsBuilt) {
+    // Categories are interned in the heap, so rows are grouped by ref first
+    // and each distinct category is decoded once.
+    QHash<quint32, std::vector<int>> byRef;
+    for (int row = 0; row < rowCount(); ++row) {
+      byRef[categoryRefAt(row)].push_back(row);
+    }
+    for (auto it = byRef.begin(); it != byRef.end(); ++it) {
+      std::vector<int> &merged = categoryRows[textAt(it.key()).toLower()];
+      size_t middle = merged.size();
+      merged.insert(merged.end(), it.value().begin(), it.value().end());
+      std::inplace_merge(merged.begin(), merged.begin() + middle,
+                         merged.end());
+    }
+    categoryRowsBuilt = true;
+  }
+  auto it = categoryRows.constFind(category.toLower());
+  return it != categoryRows.constEnd() ? it.value() : NO_ROWS;
+}
+
+bool ProductColumnFile::write(QIODevice &device,
+                              const std::vector<Product> &products) {
+  const qint64 rowTotal = static_cast<qint64>(products.size());
+
+  QByteArray heap;
+  QHash<QByteArray, quint32> interned;
+  auto intern = [&heap, &interned](const std::string &text) -> quint32 {
+    QByteArray bytes(text.data(), static_cast<qsizetype>(text.size()));
+    auto it = interned.constFind(bytes);
+    if (it != interned.constEnd()) {
+      return it.value();
+    }
+
+    quint32 ref = static_cast<quint32>(heap.size());
+    uchar length[4];
+    qToLittleEndian<quint32>(static_cast<quint32>(bytes.size()), length);
+    heap.append(reinterpret_cast<const char *>(length), 4);
+    heap.append(bytes);
+    interned.insert(bytes, ref);
+    return ref;
+  };
+
+  QByteArray columns(COLUMN_HEADER_SIZE + COLUMN_ROW_WIDTH * rowTotal, '\0');
+  uchar *out = reinterpret_cast<uchar *>(columns.data());
+  uchar *prices = out + COLUMN_HEADER_SIZE;
+  uchar *ids = prices + 8 * rowTotal;
+  uchar *quantities = ids + 4 * rowTotal;
+  uchar *nameRefs = quantities + 4 * rowTotal;
+  uchar *categoryRefs = nameRefs + 4 * rowTotal;
+
+  for (qint64 row = 0; row < rowTotal; ++row) {
+    const Product &product = products[static_cast<size_t>(row)];
+    qToLittleEndian<quint64>(std::bit_cast<quint64>(product.getUnitPrice()),
+                             prices + 8 * row);
+    qToLittleEndian<qint32>(product.getId(), ids + 4 * row);
+    qToLittleEndian<qint32>(product.getQuantity(), quantities + 4 * row);
+    qToLittleEndian<quint32>(intern(product.getName()), nameRefs + 4 * row);
+    qToLittleEndian<quint32>(intern(product.getCategory()),
+                             categoryRefs + 4 * row);
+  }
+
+  qToLittleEndian<quint32>(COLUMN_FILE_MAGIC, out);
+  qToLittleEndian<quint32>(COLUMN_FILE_VERSION, out + 4);
+  qToLittleEndian<quint32>(static_cast<quint32>(rowTotal), out + 8);
+  qToLittleEndian<quint32>(static_cast<quint32>(heap.size()), out + 12);
+
+  if (device.write(columns) != columns.size() ||
+      device.write(heap) != heap.size()) {
+    qDebug() << "Error writing product column file";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,367 @@
+#include "managers/RecordLog.h"
+#include "managers/Crc32c.h"
+#include <QDebug>
+#include <QFile>
+#include <QIODevice>
+#include <QtEndian>
+
+// Version 2 frames every record as marker, CRC-32C, then length, op and key
+// (the checksummed head) and the payload. Version 1 records carry no frame
+// and start with the op byte, which is never the marker's first byte, so a
+// version 1 log keeps its header and later appends mix framed records in. A
+// version 2 log holds framed records only; anything else there is damage.
+static const quint32 LOG_FORMAT_VERSION = 2;
+static const quint32 LEGACY_FORMAT_VERSION = 1;
+static const quint32 FRAME_MARKER = 0x5246524D;
+static const int FRAME_HEAD_SIZE = 9;
+static const qint64 RESYNC_CHUNK_SIZE = 64 * 1024;
+
+static bool isLegacyRecordStart(char lead) {
+  return lead == static_cast<char>(RecordLog::Op::Upsert) ||
+         lead == static_cast<char>(RecordLog::Op::Tombstone);
+}
+
+// Returns the offset of the next frame marker at or after from, or -1.
+static qint64 findFrame(QFile &file, qint64 from) {
+  char marker[sizeof(FRAME_MARKER)];
+  qToBigEndian(FRAME_MARKER, marker);
+  const QByteArray needle(marker, sizeof(marker));
+
+  while (file.seek(from)) {
+    QByteArray chunk = file.read(RESYNC_CHUNK_SIZE);
+    if (chunk.size() < needle.size()) {
+      return -1;
+    }
+    qsizetype at = chunk.indexOf(needle);
+    if (at >= 0) {
+      return from + at;
+    }
+    from += chunk.size() - (needle.size() - 1);
+  }
+  return -1;
+}
+
+RecordLog::RecordLog(const QString &filePath, quint32 magic)
+    : filePath(filePath), magic(magic) {}
+
+qint64 RecordLog::size() const {
+  QFile file(filePath);
+  return file.exists() ? file.size() : 0;
+}
+
+bool RecordLog::exists() const { return QFile::exists(filePath); }
+
+qint64 RecordLog::headerSize() {
+  return static_cast<qint64>(sizeof(quint32) * 2);
+}
+
+quint32 RecordLog::readVersion(QDataStream &stream) {
+  quint32 fileMagic = 0;
+  quint32 version = 0;
+  stream >> fileMagic >> version;
+  return stream.status() == QDataStream::Ok ? version : 0;
+}
+
+bool RecordLog::hasHeader() const {
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_6_0);
+
+  quint32 fileMagic = 0;
+  quint32 version = 0;
+  in >> fileMagic >> version;
+
+  file.close();
+  return in.status() == QDataStream::Ok && fileMagic == magic;
+}
+
+bool RecordLog::create() {
+  QFile file(filePath);
+  if (file.exists() && file.size() > 0) {
+    return true;
+  }
+
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    qDebug() << "Cannot create record log:" << filePath;
+    return false;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_6_0);
+  writeHeader(out);
+
+  file.close();
+  return out.status() == QDataStream::Ok;
+}
+
+bool RecordLog::truncate(qint64 validEnd) {
+  QFile file(filePath);
+  if (!file.exists() || file.size() <= validEnd) {
+    return true;
+  }
+
+  qDebug() << "Dropping incomplete tail of record log:" << filePath << "at"
+           << validEnd;
+  return file.resize(validEnd);
+}
+
+qint64 RecordLog::append(Op op, qint32 key, const QByteArray &payload,
+                         qint64 *length) {
+  QFile file(filePath);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    qDebug() << "Error opening record log for append:" << filePath;
+    return -1;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_6_0);
+
+  if (file.size() == 0) {
+    writeHeader(out);
+  }
+  qint64 offset = file.pos();
+
+  Record record;
+  record.op = op;
+  record.key = key;
+  record.payload = payload;
+  writeRecord(out, record);
+  if (length) {
+    *length = file.pos() - offset;
+  }
+
+  file.close();
+  if (out.status() != QDataStream::Ok) {
+    qDebug() << "Error appending to record log:" << filePath;
+    return -1;
+  }
+  return offset;
+}
+
+bool RecordLog::append(std::vector<Record> &records) {
+  QFile file(filePath);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    qDebug() << "Error opening record log for append:" << filePath;
+    return false;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_6_0);
+
+  if (file.size() == 0) {
+    writeHeader(out);
+  }
+  for (auto &record : records) {
+    record.offset = file.pos();
+    writeRecord(out, record);
+    record.length = file.pos() - record.offset;
+  }
+
+  file.close();
+  if (out.status() != QDataStream::Ok) {
+    qDebug() << "Error appending to record log:" << filePath;
+    return false;
+  }
+  return true;
+}
+
+bool RecordLog::readAt(qint64 offset, Record &record) const {
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_6_0);
+
+  quint32 version = readVersion(in);
+  if (offset < headerSize() || !file.seek(offset)) {
+    file.close();
+    return false;
+  }
+
+  bool ok = readRecord(in, record, version);
+  record.offset = offset;
+  record.length = file.pos() - offset;
+
+  file.close();
+  return ok;
+}
+
+bool RecordLog::scan(const std::function<void(const Record &)> &visitor,
+                     qint64 from, qint64 *validEnd, SkipReport *skips) const {
+  if (validEnd) {
+    *validEnd = headerSize();
+  }
+  if (skips) {
+    *skips = SkipReport();
+  }
+
+  QFile file(filePath);
+  if (!file.exists()) {
+    return true;
+  }
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_6_0);
+
+  quint32 fileMagic = 0;
+  quint32 version = 0;
+  in >> fileMagic >> version;
+  if (in.status() != QDataStream::Ok || fileMagic != magic) {
+    file.close();
+    return false;
+  }
+
+  if (from > headerSize()) {
+    if (!file.seek(from)) {
+      file.close();
+      return false;
+    }
+    if (validEnd) {
+      *validEnd = from;
+    }
+  }
+
+  // A record that fails to decode is skipped by resyncing at the next frame
+  // that verifies. Damage with nothing valid after it is a torn tail, which
+  // validEnd leaves for the caller to truncate.
+  Record record;
+  qint64 end = file.pos();
+  while (!in.atEnd()) {
+    qint64 offset = file.pos();
+    bool ok = readRecord(in, record, version);
+    qint64 resume = offset;
+    while (!ok) {
+      resume = findFrame(file, resume + 1);
+      if (resume < 0) {
+        break;
+      }
+      file.seek(resume);
+      in.resetStatus();
+      ok = readRecord(in, record, version);
+    }
+    if (!ok) {
+      break;
+    }
+    if (resume != offset) {
+      qDebug() << "Skipped" << resume - offset
+               << "corrupt bytes in record log:" << filePath << "at"
+               << offset;
+      if (skips) {
+        skips->skipped.emplace_back(offset, resume - offset);
+      }
+      offset = resume;
+    }
+
+    record.offset = offset;
+    record.length = file.pos() - offset;
+    visitor(record);
+    end = file.pos();
+    if (validEnd) {
+      *validEnd = end;
+    }
+  }
+
+  if (skips) {
+    skips->tailBytes = file.size() - end;
+  }
+  file.close();
+  return true;
+}
+
+void RecordLog::writeHeader(QDataStream &stream) const {
+  stream << magic;
+  stream << LOG_FORMAT_VERSION;
+}
+
+void RecordLog::writeRecord(QDataStream &stream, const Record &record) {
+  char head[FRAME_HEAD_SIZE];
+  qToBigEndian(static_cast<quint32>(record.payload.size()), head);
+  head[4] = static_cast<char>(record.op);
+  qToBigEndian(record.key, head + 5);
+  quint32 crc = Crc32c::update(Crc32c::compute(head, sizeof(head)),
+                               record.payload.constData(),
+                               record.payload.size());
+
+  stream << FRAME_MARKER << crc;
+  stream.writeRawData(head, sizeof(head));
+  stream.writeRawData(record.payload.constData(), record.payload.size());
+}
+
+bool RecordLog::readRecord(QDataStream &stream, Record &record,
+                           quint32 version) {
+  if (stream.atEnd()) {
+    return false;
+  }
+
+  char lead = 0;
+  if (stream.device()->peek(&lead, 1) != 1) {
+    return false;
+  }
+  if (version == LEGACY_FORMAT_VERSION && isLegacyRecordStart(lead)) {
+    return readLegacyRecord(stream, record);
+  }
+
+  quint32 marker = 0;
+  quint32 crc = 0;
+  stream >> marker >> crc;
+  if (stream.status() != QDataStream::Ok || marker != FRAME_MARKER)
+    return false;
+
+  char head[FRAME_HEAD_SIZE];
+  if (stream.readRawData(head, sizeof(head)) != FRAME_HEAD_SIZE)
+    return false;
+
+  // A damaged length must not turn into a huge allocation.
+  quint32 length = qFromBigEndian<quint32>(head);
+  if (length > stream.device()->bytesAvailable())
+    return false;
+
+  record.payload.resize(length);
+  if (stream.readRawData(record.payload.data(), length) !=
+      static_cast<int>(length))
+    return false;
+
+  quint32 actual = Crc32c::update(Crc32c::compute(head, sizeof(head)),
+                                  record.payload.constData(), length);
+  if (actual != crc)
+    return false;
+
+  quint8 op = static_cast<quint8>(head[4]);
+  if (op != static_cast<quint8>(Op::Upsert) &&
+      op != static_cast<quint8>(Op::Tombstone))
+    return false;
+  record.op = static_cast<Op>(op);
+  record.key = qFromBigEndian<qint32>(head + 5);
+  return true;
+}
+
+bool RecordLog::readLegacyRecord(QDataStream &stream, Record &record) {
+  quint8 op;
+  stream >> op;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+  if (op != static_cast<quint8>(Op::Upsert) &&
+      op != static_cast<quint8>(Op::Tombstone))
+    return false;
+  record.op = static_cast<Op>(op);
+
+  stream >> record.key;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+
+  stream >> record.payload;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+
+  return true;
+}
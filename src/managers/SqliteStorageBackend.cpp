@@ -0,0 +1,790 @@
+#include "managers/SqliteStorageBackend.h"
+#include <QDebug>
+#include <QDir>
+#include <QSqlError>
+#include <QStandardPaths>
+#include <QThread>
+#include <algorithm>
+
+static const char *SQLITE_DRIVER = "QSQLITE";
+static const size_t ID_CHUNK_SIZE = 500;
+static const int DEFAULT_CACHE_PAGES = -2000;
+static const int RESIDENT_CACHE_PAGES = -65536;
+
+static const QString PRODUCT_COLUMNS =
+    "id, name, category, quantity, unit_price";
+static const QString ORDER_COLUMNS =
+    "id, company, contact, phone, order_type, order_date, item_count, "
+    "total_amount, total_discount";
+static const QString ORDER_ITEM_COLUMNS =
+    "order_id, product_id, product_name, category, quantity, unit_price, "
+    "discount_percent, total_price";
+
+SqliteStorageBackend::SqliteStorageBackend()
+    : connected(false), residentCacheEnabled(false) {
+  QString dataPath =
+      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+  QDir dir;
+  if (!dir.exists(dataPath)) {
+    dir.mkpath(dataPath);
+  }
+  databaseFilePath = dataPath + "/storage.sqlite";
+  connectionPrefix = QString("storage-%1-").arg(
+      reinterpret_cast<quintptr>(this), 0, 16);
+
+  durabilities[Store::Products] = Durability::Batched;
+  durabilities[Store::Orders] = Durability::Batched;
+  durabilities[Store::WriteOffs] = Durability::Batched;
+}
+
+SqliteStorageBackend::~SqliteStorageBackend() { disconnect(); }
+
+bool SqliteStorageBackend::connect() {
+  if (!QSqlDatabase::isDriverAvailable(SQLITE_DRIVER)) {
+    qDebug() << "SQLite driver is not available";
+    return false;
+  }
+
+  QSqlDatabase db = database();
+  if (!db.isOpen() || !createSchema(db)) {
+    qDebug() << "Cannot create/open SQLite database:" << databaseFilePath;
+    return false;
+  }
+
+  connected = true;
+  return true;
+}
+
+void SqliteStorageBackend::disconnect() {
+  std::lock_guard<std::mutex> lock(connectionMutex);
+  for (const QString &name : connectionNames) {
+    {
+      QSqlDatabase db = QSqlDatabase::database(name, false);
+      db.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+  }
+  connectionNames.clear();
+  connected = false;
+}
+
+bool SqliteStorageBackend::isConnected() const { return connected; }
+
+void SqliteStorageBackend::setResidentCacheEnabled(bool enabled) {
+  residentCacheEnabled = enabled;
+
+  // SQLite keeps pages in its own cache, so "resident" only widens it.
+  QSqlDatabase db = database();
+  QSqlQuery query(db);
+  run(query, QString("PRAGMA cache_size = %1")
+                 .arg(enabled ? RESIDENT_CACHE_PAGES : DEFAULT_CACHE_PAGES));
+}
+
+void SqliteStorageBackend::setDurability(Store store, Durability durability) {
+  durabilities[store] = durability;
+
+  std::lock_guard<std::mutex> lock(connectionMutex);
+  for (const QString &name : connectionNames) {
+    QSqlDatabase db = QSqlDatabase::database(name, false);
+    applySynchronousMode(db);
+  }
+}
+
+Durability SqliteStorageBackend::durability(Store store) const {
+  auto it = durabilities.find(store);
+  return it != durabilities.end() ? it->second : Durability::Batched;
+}
+
+bool SqliteStorageBackend::flush() {
+  if (!connected) {
+    return true;
+  }
+
+  QSqlDatabase db = database();
+  QSqlQuery query(db);
+  return run(query, "PRAGMA wal_checkpoint(FULL)");
+}
+
+int SqliteStorageBackend::maxId(Store store) {
+  QString table = store == Store::Products ? "products"
+                  : store == Store::Orders ? "orders"
+                                           : "write_offs";
+  QSqlDatabase db = database();
+  QSqlQuery query(db);
+  if (!run(query, QString("SELECT MAX(id) FROM %1").arg(table)) ||
+      !query.next()) {
+    return 0;
+  }
+  return query.value(0).toInt();
+}
+
+QSqlDatabase SqliteStorageBackend::database() {
+  // Qt SQL connections may only be used by the thread that opened them, and
+  // writes arrive on DatabaseManager's writer thread, so each thread gets
+  // its own connection to the same file.
+  QString name =
+      connectionPrefix +
+      QString::number(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+
+  std::lock_guard<std::mutex> lock(connectionMutex);
+  if (QSqlDatabase::contains(name)) {
+    return QSqlDatabase::database(name);
+  }
+
+  QSqlDatabase db = QSqlDatabase::addDatabase(SQLITE_DRIVER, name);
+  db.setDatabaseName(databaseFilePath);
+  connectionNames << name;
+  if (!db.open()) {
+    qDebug() << "Error opening SQLite database:" << db.lastError().text();
+    return db;
+  }
+
+  QSqlQuery query(db);
+  run(query, "PRAGMA journal_mode = WAL");
+  run(query, "PRAGMA busy_timeout = 5000");
+  if (residentCacheEnabled) {
+    run(query, QString("PRAGMA cache_size = %1").arg(RESIDENT_CACHE_PAGES));
+  }
+  applySynchronousMode(db);
+  return db;
+}
+
+bool SqliteStorageBackend::createSchema(QSqlDatabase &db) {
+  static const char *statements[] = {
+      "CREATE TABLE IF NOT EXISTS products ("
+      " id INTEGER PRIMARY KEY, name TEXT NOT NULL, name_key TEXT NOT NULL,"
+      " category TEXT NOT NULL, category_key TEXT NOT NULL,"
+      " quantity INTEGER NOT NULL, unit_price REAL NOT NULL)",
+      "CREATE INDEX IF NOT EXISTS products_category ON products(category_key)",
+      "CREATE TABLE IF NOT EXISTS orders ("
+      " id INTEGER PRIMARY KEY, company TEXT NOT NULL,"
+      " company_key TEXT NOT NULL, contact TEXT NOT NULL, phone TEXT NOT NULL,"
+      " order_type INTEGER NOT NULL, order_date TEXT NOT NULL,"
+      " item_count INTEGER NOT NULL, total_amount REAL NOT NULL,"
+      " total_discount REAL NOT NULL)",
+      "CREATE INDEX IF NOT EXISTS orders_date ON orders(order_date)",
+      "CREATE INDEX IF NOT EXISTS orders_company ON orders(company_key)",
+      "CREATE INDEX IF NOT EXISTS orders_type ON orders(order_type)",
+      "CREATE TABLE IF NOT EXISTS order_items ("
+      " order_id INTEGER NOT NULL, position INTEGER NOT NULL,"
+      " product_id INTEGER NOT NULL, product_name TEXT NOT NULL,"
+      " category TEXT NOT NULL, quantity INTEGER NOT NULL,"
+      " unit_price REAL NOT NULL, discount_percent REAL NOT NULL,"
+      " total_price REAL NOT NULL, PRIMARY KEY(order_id, position))"
+      " WITHOUT ROWID",
+      "CREATE TABLE IF NOT EXISTS write_offs ("
+      " id INTEGER PRIMARY KEY AUTOINCREMENT, product_id INTEGER NOT NULL,"
+      " product_name TEXT NOT NULL, quantity INTEGER NOT NULL,"
+      " value REAL NOT NULL, reason TEXT NOT NULL)"};
+
+  if (!db.transaction()) {
+    return false;
+  }
+
+  QSqlQuery query(db);
+  for (const char *statement : statements) {
+    if (!run(query, statement)) {
+      db.rollback();
+      return false;
+    }
+  }
+  return db.commit();
+}
+
+void SqliteStorageBackend::applySynchronousMode(QSqlDatabase &db) {
+  if (!db.isOpen()) {
+    return;
+  }
+  QSqlQuery query(db);
+  run(query, "PRAGMA synchronous = " + synchronousMode());
+}
+
+QString SqliteStorageBackend::synchronousMode() const {
+  // One database file holds every store, so the strictest setting wins.
+  bool batched = false;
+  for (const auto &entry : durabilities) {
+    if (entry.second == Durability::Sync) {
+      return "FULL";
+    }
+    batched = batched || entry.second == Durability::Batched;
+  }
+  return batched ? "NORMAL" : "OFF";
+}
+
+bool SqliteStorageBackend::run(QSqlQuery &query) {
+  if (!query.exec()) {
+    qDebug() << "SQLite error:" << query.lastError().text();
+    return false;
+  }
+  return true;
+}
+
+bool SqliteStorageBackend::run(QSqlQuery &query, const QString &statement) {
+  if (!query.exec(statement)) {
+    qDebug() << "SQLite error:" << query.lastError().text() << "in"
+             << statement;
+    return false;
+  }
+  return true;
+}
+
+bool SqliteStorageBackend::addProduct(const Product &product) {
+  return writeProducts(std::span<const Product>(&product, 1), false).front();
+}
+
+bool SqliteStorageBackend::updateProduct(const Product &product) {
+  return writeProducts(std::span<const Product>(&product, 1), true).front();
+}
+
+std::vector<bool>
+SqliteStorageBackend::addProducts(std::span<const Product> products) {
+  return writeProducts(products, false);
+}
+
+std::vector<bool>
+SqliteStorageBackend::updateProducts(std::span<const Product> products) {
+  return writeProducts(products, true);
+}
+
+std::vector<bool>
+SqliteStorageBackend::writeProducts(std::span<const Product> products,
+                                    bool existingOnly) {
+  std::vector<bool> results(products.size(), false);
+  if (products.empty()) {
+    return results;
+  }
+
+  QSqlDatabase db = database();
+  if (!db.transaction()) {
+    qDebug() << "Cannot start SQLite transaction:" << db.lastError().text();
+    return results;
+  }
+
+  QSqlQuery query(db);
+  query.prepare(existingOnly
+                    ? "UPDATE products SET name = :name, name_key = :name_key,"
+                      " category = :category, category_key = :category_key,"
+                      " quantity = :quantity, unit_price = :unit_price"
+                      " WHERE id = :id"
+                    : "INSERT OR REPLACE INTO products (id, name, name_key,"
+                      " category, category_key, quantity, unit_price) VALUES"
+                      " (:id, :name, :name_key, :category, :category_key,"
+                      " :quantity, :unit_price)");
+
+  for (size_t i = 0; i < products.size(); ++i) {
+    bindProduct(query, products[i]);
+    results[i] = run(query) && query.numRowsAffected() > 0;
+  }
+
+  if (!db.commit()) {
+    qDebug() << "Error committing products:" << db.lastError().text();
+    db.rollback();
+    results.assign(products.size(), false);
+  }
+  return results;
+}
+
+void SqliteStorageBackend::bindProduct(QSqlQuery &query,
+                                       const Product &product) {
+  QString name = QString::fromStdString(product.getName());
+  QString category = QString::fromStdString(product.getCategory());
+  query.bindValue(":id", product.getId());
+  query.bindValue(":name", name);
+  query.bindValue(":name_key", name.toLower());
+  query.bindValue(":category", category);
+  query.bindValue(":category_key", category.toLower());
+  query.bindValue(":quantity", product.getQuantity());
+  query.bindValue(":unit_price", product.getUnitPrice());
+}
+
+Product SqliteStorageBackend::productFromQuery(const QSqlQuery &query) {
+  Product product(query.value(1).toString().toStdString(),
+                  query.value(2).toString().toStdString(),
+                  query.value(3).toInt(), query.value(4).toDouble());
+  product.setId(query.value(0).toInt());
+  return product;
+}
+
+bool SqliteStorageBackend::deleteProduct(int id) {
+  QSqlDatabase db = database();
+  QSqlQuery query(db);
+  query.prepare("DELETE FROM products WHERE id = ?");
+  query.addBindValue(id);
+  return run(query) && query.numRowsAffected() > 0;
+}
+
+Product SqliteStorageBackend::getProduct(int id) {
+  std::vector<Product> products = queryProducts("id = ?", {id});
+  return products.empty() ? Product() : products.front();
+}
+
+std::vector<Product> SqliteStorageBackend::getAllProducts() {
+  return queryProducts(QString(), {});
+}
+
+std::vector<Product>
+SqliteStorageBackend::searchProductsByName(const QString &name) {
+  return queryProducts("instr(name_key, ?) > 0", {name.toLower()});
+}
+
+std::vector<Product>
+SqliteStorageBackend::searchProductsByCategory(const QString &category) {
+  return queryProducts("category_key = ?", {category.toLower()});
+}
+
+std::vector<Product>
+SqliteStorageBackend::queryProducts(const QString &condition,
+                                    const QVariantList &values) {
+  std::vector<Product> products;
+
+  QSqlDatabase db = database();
+  QSqlQuery query(db);
+  query.setForwardOnly(true);
+  query.prepare(QString("SELECT %1 FROM products%2 ORDER BY id")
+                    .arg(PRODUCT_COLUMNS,
+                         condition.isEmpty() ? QString()
+                                             : " WHERE " + condition));
+  for (const QVariant &value : values) {
+    query.addBindValue(value);
+  }
+  if (!run(query)) {
+    return products;
+  }
+
+  while (query.next()) {
+    products.push_back(productFromQuery(query));
+  }
+  return products;
+}
+
+double SqliteStorageBackend::calculateTotalInventoryValue() {
+  QSqlDatabase db = database();
+  QSqlQuery query(db);
+  if (!run(query, "SELECT TOTAL(quantity * unit_price) FROM products") ||
+      !query.next()) {
+    return 0.0;
+  }
+  return query.value(0).toDouble();
+}
+
+int SqliteStorageBackend::getTotalProductQuantity() {
+  QSqlDatabase db = database();
+  QSqlQuery query(db);
+  if (!run(query, "SELECT TOTAL(quantity) FROM products") || !query.next()) {
+    return 0;
+  }
+  return static_cast<int>(query.value(0).toLongLong());
+}
+
+std::vector<bool> SqliteStorageBackend::addWriteOffRecords(
+    std::span<const WriteOffRecord> records) {
+  std::vector<bool> results(records.size(), false);
+  if (records.empty()) {
+    return results;
+  }
+
+  QSqlDatabase db = database();
+  if (!db.transaction()) {
+    qDebug() << "Cannot start SQLite transaction:" << db.lastError().text();
+    return results;
+  }
+
+  QSqlQuery query(db);
+  query.prepare("INSERT INTO write_offs (product_id, product_name, quantity,"
+                " value, reason) VALUES (?, ?, ?, ?, ?)");
+  for (size_t i = 0; i < records.size(); ++i) {
+    const WriteOffRecord &record = records[i];
+    query.addBindValue(record.productId);
+    query.addBindValue(QString::fromStdString(record.productName));
+    query.addBindValue(record.quantity);
+    query.addBindValue(record.value);
+    query.addBindValue(record.reason.isEmpty() ? QString("No reason provided")
+                                               : record.reason);
+    results[i] = run(query);
+  }
+
+  if (!db.commit()) {
+    qDebug() << "Error committing write-offs:" << db.lastError().text();
+    db.rollback();
+    results.assign(records.size(), false);
+  }
+  return results;
+}
+
+std::vector<QStringList> SqliteStorageBackend::getWriteOffHistory() {
+  std::vector<QStringList> history;
+
+  QSqlDatabase db = database();
+  QSqlQuery query(db);
+  query.setForwardOnly(true);
+  if (!run(query, "SELECT id, product_name, quantity, value, reason"
+                  " FROM write_offs ORDER BY id DESC")) {
+    return history;
+  }
+
+  while (query.next()) {
+    QStringList list;
+    list << QString::number(query.value(0).toInt());
+    list << query.value(1).toString();
+    list << QString::number(query.value(2).toInt());
+    list << QString::number(query.value(3).toDouble(), 'f', 2);
+    list << query.value(4).toString();
+    history.push_back(list);
+  }
+  return history;
+}
+
+bool SqliteStorageBackend::addOrder(const Order &order) {
+  return writeOrders(std::span<const Order>(&order, 1), false).front();
+}
+
+std::vector<bool>
+SqliteStorageBackend::addOrders(std::span<const Order> orders) {
+  return writeOrders(orders, false);
+}
+
+bool SqliteStorageBackend::updateOrder(const Order &order) {
+  return writeOrders(std::span<const Order>(&order, 1), true).front();
+}
+
+std::vector<bool>
+SqliteStorageBackend::writeOrders(std::span<const Order> orders,
+                                  bool existingOnly) {
+  std::vector<bool> results(orders.size(), false);
+  if (orders.empty()) {
+    return results;
+  }
+
+  QSqlDatabase db = database();
+  if (!db.transaction()) {
+    qDebug() << "Cannot start SQLite transaction:" << db.lastError().text();
+    return results;
+  }
+
+  QSqlQuery exists(db);
+  exists.prepare("SELECT 1 FROM orders WHERE id = ?");
+  QSqlQuery orderQuery(db);
+  orderQuery.prepare(
+      "INSERT OR REPLACE INTO orders (id, company, company_key, contact, phone,"
+      " order_type, order_date, item_count, total_amount, total_discount)"
+      " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+  QSqlQuery clearItems(db);
+  clearItems.prepare("DELETE FROM order_items WHERE order_id = ?");
+  QSqlQuery itemQuery(db);
+  itemQuery.prepare(
+      "INSERT INTO order_items (order_id, position, product_id, product_name,"
+      " category, quantity, unit_price, discount_percent, total_price)"
+      " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+  QSqlQuery savepoint(db);
+
+  for (size_t i = 0; i < orders.size(); ++i) {
+    if (existingOnly) {
+      exists.addBindValue(orders[i].getId());
+      bool found = run(exists) && exists.next();
+      exists.finish();
+      if (!found) {
+        continue;
+      }
+    }
+
+    // A savepoint per order keeps a half-written order (header without all
+    // of its items) out of the batch when one of its statements fails.
+    if (!run(savepoint, "SAVEPOINT order_write")) {
+      continue;
+    }
+    results[i] = writeOrder(orderQuery, clearItems, itemQuery, orders[i]);
+    if (!results[i]) {
+      run(savepoint, "ROLLBACK TO order_write");
+    }
+    run(savepoint, "RELEASE order_write");
+  }
+
+  if (!db.commit()) {
+    qDebug() << "Error committing orders:" << db.lastError().text();
+    db.rollback();
+    results.assign(orders.size(), false);
+  }
+  return results;
+}
+
+bool SqliteStorageBackend::writeOrder(QSqlQuery &orderQuery,
+                                      QSqlQuery &clearItems,
+                                      QSqlQuery &itemQuery,
+                                      const Order &order) {
+  const auto &items = order.getItems();
+  orderQuery.addBindValue(order.getId());
+  orderQuery.addBindValue(order.getCompanyName());
+  orderQuery.addBindValue(companyKey(order.getCompanyName()));
+  orderQuery.addBindValue(order.getContactPerson());
+  orderQuery.addBindValue(order.getPhone());
+  orderQuery.addBindValue(static_cast<int>(order.getOrderType()));
+  orderQuery.addBindValue(dateKey(order.getOrderDate()));
+  orderQuery.addBindValue(static_cast<int>(items.size()));
+  orderQuery.addBindValue(order.getTotalAmount());
+  orderQuery.addBindValue(order.getTotalDiscount());
+  if (!run(orderQuery)) {
+    return false;
+  }
+
+  clearItems.addBindValue(order.getId());
+  if (!run(clearItems)) {
+    return false;
+  }
+
+  for (size_t position = 0; position < items.size(); ++position) {
+    const OrderItem &item = items[position];
+    itemQuery.addBindValue(order.getId());
+    itemQuery.addBindValue(static_cast<int>(position));
+    itemQuery.addBindValue(item.productId);
+    itemQuery.addBindValue(item.productName);
+    itemQuery.addBindValue(item.category);
+    itemQuery.addBindValue(item.quantity);
+    itemQuery.addBindValue(item.unitPrice);
+    itemQuery.addBindValue(item.discountPercent);
+    itemQuery.addBindValue(item.totalPrice);
+    if (!run(itemQuery)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SqliteStorageBackend::deleteOrder(int id) {
+  QSqlDatabase db = database();
+  if (!db.transaction()) {
+    return false;
+  }
+
+  QSqlQuery query(db);
+  query.prepare("DELETE FROM orders WHERE id = ?");
+  query.addBindValue(id);
+  bool deleted = run(query) && query.numRowsAffected() > 0;
+
+  query.prepare("DELETE FROM order_items WHERE order_id = ?");
+  query.addBindValue(id);
+  if (!deleted || !run(query) || !db.commit()) {
+    db.rollback();
+    return false;
+  }
+  return true;
+}
+
+Order SqliteStorageBackend::getOrder(int id) {
+  std::vector<Order> orders = queryOrders("id = ?", {id});
+  return orders.empty() ? Order() : orders.front();
+}
+
+std::vector<Order> SqliteStorageBackend::getAllOrders() {
+  return queryOrders(QString(), {});
+}
+
+bool SqliteStorageBackend::forEachOrder(
+    const std::function<void(const Order &)> &visitor) {
+  return visitOrders(QString(), {}, visitor);
+}
+
+std::vector<Order>
+SqliteStorageBackend::getOrdersByCompany(const QString &companyName) {
+  return queryOrders("instr(company_key, ?) > 0", {companyKey(companyName)});
+}
+
+std::vector<Order>
+SqliteStorageBackend::getOrdersByCompanyPrefix(const QString &prefix) {
+  // GLOB is case sensitive and can use the company_key index for a prefix.
+  return queryOrders("company_key GLOB ?", {globPrefix(companyKey(prefix))});
+}
+
+std::vector<Order> SqliteStorageBackend::getOrdersByType(OrderType type) {
+  return queryOrders("order_type = ?", {static_cast<int>(type)});
+}
+
+std::vector<Order>
+SqliteStorageBackend::getOrdersByDateRange(const QDate &startDate,
+                                           const QDate &endDate) {
+  return queryOrders("order_date BETWEEN ? AND ?",
+                     {dateKey(startDate), dateKey(endDate)});
+}
+
+std::vector<Order> SqliteStorageBackend::getOrders(std::vector<int> ids) {
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+  std::vector<Order> orders;
+  orders.reserve(ids.size());
+  auto collect = [&orders](const Order &order) { orders.push_back(order); };
+  for (size_t from = 0; from < ids.size(); from += ID_CHUNK_SIZE) {
+    QString condition = "id IN (" + idList(ids, from, ID_CHUNK_SIZE) + ")";
+    if (!visitOrders(condition, {}, collect)) {
+      return std::vector<Order>();
+    }
+  }
+  return orders;
+}
+
+std::vector<Order>
+SqliteStorageBackend::queryOrders(const QString &condition,
+                                  const QVariantList &values) {
+  std::vector<Order> orders;
+  auto collect = [&orders](const Order &order) { orders.push_back(order); };
+  if (!visitOrders(condition, values, collect)) {
+    return std::vector<Order>();
+  }
+  return orders;
+}
+
+bool SqliteStorageBackend::visitOrders(
+    const QString &condition, const QVariantList &values,
+    const std::function<void(const Order &)> &visitor) {
+  QString where = condition.isEmpty() ? QString() : " WHERE " + condition;
+
+  QSqlDatabase db = database();
+  QSqlQuery orderQuery(db);
+  orderQuery.setForwardOnly(true);
+  orderQuery.prepare(
+      QString("SELECT %1 FROM orders%2 ORDER BY id").arg(ORDER_COLUMNS, where));
+  QSqlQuery itemQuery(db);
+  itemQuery.setForwardOnly(true);
+  itemQuery.prepare(
+      QString("SELECT %1 FROM order_items%2 ORDER BY order_id, position")
+          .arg(ORDER_ITEM_COLUMNS,
+               condition.isEmpty()
+                   ? QString()
+                   : " WHERE order_id IN (SELECT id FROM orders" + where +
+                         ")"));
+  for (const QVariant &value : values) {
+    orderQuery.addBindValue(value);
+    itemQuery.addBindValue(value);
+  }
+  if (!run(orderQuery) || !run(itemQuery)) {
+    return false;
+  }
+
+  // Both cursors are ordered by order id, so items are merged in one pass
+  // without holding more than the current order in memory.
+  bool hasItem = itemQuery.next();
+  while (orderQuery.next()) {
+    OrderHeader header = headerFromQuery(orderQuery);
+
+    Order order;
+    order.id = header.id;
+    order.companyName = header.companyName;
+    order.contactPerson = header.contactPerson;
+    order.phone = header.phone;
+    order.orderType = header.orderType;
+    order.orderDate = header.orderDate;
+    order.totalAmount = header.totalAmount;
+    order.totalDiscount = header.totalDiscount;
+    order.items.reserve(header.itemCount);
+
+    while (hasItem && itemQuery.value(0).toInt() < header.id) {
+      hasItem = itemQuery.next();
+    }
+    while (hasItem && itemQuery.value(0).toInt() == header.id) {
+      OrderItem item;
+      item.productId = itemQuery.value(1).toInt();
+      item.productName = itemQuery.value(2).toString();
+      item.category = itemQuery.value(3).toString();
+      item.quantity = itemQuery.value(4).toInt();
+      item.unitPrice = itemQuery.value(5).toDouble();
+      item.discountPercent = itemQuery.value(6).toDouble();
+      item.totalPrice = itemQuery.value(7).toDouble();
+      order.items.push_back(item);
+      hasItem = itemQuery.next();
+    }
+
+    visitor(order);
+  }
+  return true;
+}
+
+std::vector<OrderHeader> SqliteStorageBackend::getOrderHeaders() {
+  return queryOrderHeaders(QString(), {});
+}
+
+std::vector<OrderHeader>
+SqliteStorageBackend::getOrderHeadersByCompany(const QString &companyName) {
+  return queryOrderHeaders("instr(company_key, ?) > 0",
+                           {companyKey(companyName)});
+}
+
+std::vector<OrderHeader>
+SqliteStorageBackend::getOrderHeadersByType(OrderType type) {
+  return queryOrderHeaders("order_type = ?", {static_cast<int>(type)});
+}
+
+std::vector<OrderHeader>
+SqliteStorageBackend::getOrderHeadersByDateRange(const QDate &startDate,
+                                                 const QDate &endDate) {
+  return queryOrderHeaders("order_date BETWEEN ? AND ?",
+                           {dateKey(startDate), dateKey(endDate)});
+}
+
+std::vector<OrderHeader>
+SqliteStorageBackend::queryOrderHeaders(const QString &condition,
+                                        const QVariantList &values) {
+  std::vector<OrderHeader> headers;
+
+  QSqlDatabase db = database();
+  QSqlQuery query(db);
+  query.setForwardOnly(true);
+  query.prepare(QString("SELECT %1 FROM orders%2 ORDER BY id")
+                    .arg(ORDER_COLUMNS,
+                         condition.isEmpty() ? QString()
+                                             : " WHERE " + condition));
+  for (const QVariant &value : values) {
+    query.addBindValue(value);
+  }
+  if (!run(query)) {
+    return headers;
+  }
+
+  while (query.next()) {
+    headers.push_back(headerFromQuery(query));
+  }
+  return headers;
+}
+
+OrderHeader SqliteStorageBackend::headerFromQuery(const QSqlQuery &query) {
+  OrderHeader header;
+  header.id = query.value(0).toInt();
+  header.companyName = query.value(1).toString();
+  header.contactPerson = query.value(2).toString();
+  header.phone = query.value(3).toString();
+  header.orderType = static_cast<OrderType>(query.value(4).toInt());
+  header.orderDate = QDate::fromString(query.value(5).toString(), Qt::ISODate);
+  header.itemCount = query.value(6).toInt();
+  header.totalAmount = query.value(7).toDouble();
+  header.totalDiscount = query.value(8).toDouble();
+  return header;
+}
+
+QString SqliteStorageBackend::companyKey(const QString &companyName) {
+  return companyName.toCaseFolded();
+}
+
+QString SqliteStorageBackend::globPrefix(const QString &prefix) {
+  QString pattern;
+  for (QChar c : prefix) {
+    if (c == '*' || c == '?' || c == '[') {
+      pattern += '[';
+      pattern += c;
+      pattern += ']';
+    } else {
+      pattern += c;
+    }
+  }
+  return pattern + '*';
+}
+
+QString SqliteStorageBackend::dateKey(const QDate &date) {
+  return date.toString(Qt::ISODate);
+}
+
+QString SqliteStorageBackend::idList(const std::vector<int> &ids, size_t from,
+                                     size_t count) {
+  QStringList list;
+  for (size_t i = from; i < ids.size() && i < from + count; ++i) {
+    list << QString::number(ids[i]);
+  }
+  return list.join(',');
+}
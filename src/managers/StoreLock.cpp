@@ -0,0 +1,90 @@
+#include "managers/StoreLock.h"
+#include <QDebug>
+#include <QtEndian>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/file.h>
+#endif
+
+StoreLock::StoreLock(const QString &filePath, Mode mode, bool wait)
+    : file(filePath), lockMode(mode), locked(false), published(nullptr) {
+  // Every lock opens its own handle: flock and LockFileEx only exclude
+  // other open handles, which is what keeps threads apart as well.
+  if (!file.open(QIODevice::ReadWrite)) {
+    qDebug() << "Cannot open lock file:" << filePath;
+    return;
+  }
+  locked = acquire(wait);
+  if (!locked && wait) {
+    qDebug() << "Cannot lock store:" << filePath;
+  }
+}
+
+StoreLock::~StoreLock() {
+  if (locked && published) {
+    *published = bumpGeneration();
+  }
+  if (locked) {
+    release();
+  }
+  file.close();
+}
+
+bool StoreLock::acquire(bool wait) {
+#ifdef Q_OS_WIN
+  HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(file.handle()));
+  DWORD flags = lockMode == Mode::Exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0;
+  if (!wait) {
+    flags |= LOCKFILE_FAIL_IMMEDIATELY;
+  }
+  OVERLAPPED overlapped = {};
+  return LockFileEx(handle, flags, 0, MAXDWORD, MAXDWORD, &overlapped) != 0;
+#else
+  int operation = lockMode == Mode::Exclusive ? LOCK_EX : LOCK_SH;
+  if (!wait) {
+    operation |= LOCK_NB;
+  }
+  return ::flock(file.handle(), operation) == 0;
+#endif
+}
+
+void StoreLock::release() {
+#ifdef Q_OS_WIN
+  HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(file.handle()));
+  OVERLAPPED overlapped = {};
+  UnlockFileEx(handle, 0, MAXDWORD, MAXDWORD, &overlapped);
+#else
+  ::flock(file.handle(), LOCK_UN);
+#endif
+  locked = false;
+}
+
+quint64 StoreLock::generation() {
+  uchar bytes[sizeof(quint64)] = {};
+  if (!locked || !file.seek(0) ||
+      file.read(reinterpret_cast<char *>(bytes), sizeof(bytes)) !=
+          static_cast<qint64>(sizeof(bytes))) {
+    return 0;
+  }
+  return qFromLittleEndian<quint64>(bytes);
+}
+
+quint64 StoreLock::bumpGeneration() {
+  if (!locked || lockMode != Mode::Exclusive) {
+    return generation();
+  }
+
+  uchar bytes[sizeof(quint64)];
+  quint64 next = generation() + 1;
+  qToLittleEndian(next, bytes);
+  if (!file.seek(0) ||
+      file.write(reinterpret_cast<const char *>(bytes), sizeof(bytes)) !=
+          static_cast<qint64>(sizeof(bytes)) ||
+      !file.flush()) {
+    qDebug() << "Cannot update store generation:" << file.fileName();
+  }
+  return next;
+}
@@ -0,0 +1,156 @@
+#include "managers/WriteQueue.h"
+#include <QDebug>
+#include <exception>
+
+WriteQueue::WriteQueue(size_t capacity)
+    : capacity(capacity), pendingPerScope{}, nextSequence(1), running(false),
+      stopping(false), worker(&WriteQueue::run, this) {}
+
+WriteQueue::~WriteQueue() {
+  flush();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  notEmpty.notify_all();
+  worker.join();
+}
+
+QFuture<bool> WriteQueue::submit(Task task) {
+  return submit(QString(), QString(), std::move(task));
+}
+
+QFuture<bool> WriteQueue::submit(const QString &entity,
+                                 const QString &operation, Task task) {
+  return submit(ALL_SCOPES, entity, operation, std::move(task));
+}
+
+QFuture<bool> WriteQueue::submit(Scopes scopes, const QString &entity,
+                                 const QString &operation, Task task) {
+  auto promise = std::make_shared<QPromise<bool>>();
+  promise->start();
+  QFuture<bool> future = promise->future();
+
+  if (isWriterThread()) {
+    // A queued task that writes again runs inline instead of waiting on
+    // itself.
+    promise->addResult(task());
+    promise->finish();
+    return future;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+
+  // Repeating the same operation on an entity keeps only the latest
+  // payload; every caller gets the result of the write that lands.
+  if (!entity.isEmpty() && !operation.isEmpty()) {
+    auto last = lastForEntity.constFind(entity);
+    if (last != lastForEntity.constEnd() && !queue.empty() &&
+        last.value() >= queue.front().sequence) {
+      Entry &pending = queue[last.value() - queue.front().sequence];
+      if (pending.operation == operation) {
+        countScopes(scopes & ~pending.scopes, 1);
+        pending.scopes |= scopes;
+        pending.task = std::move(task);
+        pending.promises.push_back(promise);
+        return future;
+      }
+    }
+  }
+
+  notFull.wait(lock, [this] { return queue.size() < capacity; });
+
+  Entry entry;
+  entry.sequence = nextSequence++;
+  entry.entity = entity;
+  entry.operation = operation;
+  entry.scopes = scopes;
+  entry.task = std::move(task);
+  entry.promises.push_back(promise);
+  if (!entity.isEmpty()) {
+    lastForEntity[entity] = entry.sequence;
+  }
+  countScopes(scopes, 1);
+  queue.push_back(std::move(entry));
+
+  lock.unlock();
+  notEmpty.notify_one();
+  return future;
+}
+
+void WriteQueue::flush() {
+  if (isWriterThread()) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  drained.wait(lock, [this] { return queue.empty() && !running; });
+}
+
+void WriteQueue::flush(Scopes scopes) {
+  if (isWriterThread()) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  drained.wait(lock, [this, scopes] { return !isPending(scopes); });
+}
+
+void WriteQueue::countScopes(Scopes scopes, int delta) {
+  for (size_t bit = 0; bit < pendingPerScope.size(); ++bit) {
+    if (scopes & (Scopes(1) << bit)) {
+      pendingPerScope[bit] += delta;
+    }
+  }
+}
+
+bool WriteQueue::isPending(Scopes scopes) const {
+  for (size_t bit = 0; bit < pendingPerScope.size(); ++bit) {
+    if ((scopes & (Scopes(1) << bit)) && pendingPerScope[bit] > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WriteQueue::isWriterThread() const {
+  return std::this_thread::get_id() == worker.get_id();
+}
+
+void WriteQueue::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    notEmpty.wait(lock, [this] { return stopping || !queue.empty(); });
+    if (queue.empty()) {
+      return;
+    }
+
+    Entry entry = std::move(queue.front());
+    queue.pop_front();
+    auto last = lastForEntity.find(entry.entity);
+    if (last != lastForEntity.end() && last.value() == entry.sequence) {
+      lastForEntity.erase(last);
+    }
+    running = true;
+    lock.unlock();
+    notFull.notify_one();
+
+    bool ok = false;
+    try {
+      ok = entry.task();
+    } catch (const std::exception &e) {
+      qDebug() << "Exception in queued write:" << e.what();
+    } catch (...) {
+      qDebug() << "Unknown exception in queued write";
+    }
+    for (const auto &promise : entry.promises) {
+      promise->addResult(ok);
+      promise->finish();
+    }
+
+    lock.lock();
+    running = false;
+    countScopes(entry.scopes, -1);
+    drained.notify_all();
+  }
+}
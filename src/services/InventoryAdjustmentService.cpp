@@ -1,6 +1,9 @@
 #include "services/InventoryAdjustmentService.h"
 #include "exceptions/Exceptions.h"
+#include "services/WriteOffCalculator.h"
 #include "services/WriteOffService.h"
+#include <exception>
+#include <vector>
 
 
 void InventoryAdjustmentService::applyAdjustment(InventoryService &inventory,
@@ -36,3 +39,68 @@ void InventoryAdjustmentService::applyAdjustment(InventoryService &inventory,
 
   result.itemsUpdated++;
 }
+
+void InventoryAdjustmentService::applyAdjustments(
+    InventoryService &inventory, DatabaseManager *dbManager,
+    std::span<const Adjustment> adjustments, Result &result) {
+  std::vector<WriteOffRecord> records;
+  const QString reason = "Inventory adjustment";
+
+  for (const auto &adjustment : adjustments) {
+    int difference = adjustment.actualQty - adjustment.currentQty;
+    if (difference == 0) {
+      continue;
+    }
+
+    try {
+      auto product = inventory.getProduct(adjustment.id);
+      if (!product) {
+        throw ProductException("Product with ID " +
+                               std::to_string(adjustment.id) +
+                               " not found during inventory adjustment");
+      }
+
+      if (difference > 0) {
+        inventory.addStock(adjustment.id, difference);
+        result.quantityAdded += difference;
+      } else {
+        int writeOffQty = -difference;
+
+        // Valued before the write-off lowers the stock it is checked against.
+        WriteOffRecord record;
+        record.productId = adjustment.id;
+        record.productName = product->getName().empty()
+                                 ? std::string("Unknown Product")
+                                 : product->getName();
+        record.quantity = writeOffQty;
+        record.value =
+            WriteOffCalculator::calculateWriteOffValue(*product, writeOffQty);
+        record.reason = reason;
+
+        inventory.writeOffProduct(adjustment.id, writeOffQty,
+                                  reason.toStdString());
+        records.push_back(record);
+        result.quantityWrittenOff += writeOffQty;
+      }
+
+      result.itemsUpdated++;
+    } catch (const std::exception &e) {
+      result.errors.append(QString("Failed to update product ID %1: %2")
+                               .arg(adjustment.id)
+                               .arg(e.what()));
+    }
+  }
+
+  // All write-offs of a stocktake are journalled with one append.
+  if (!dbManager || records.empty()) {
+    return;
+  }
+  std::vector<bool> saved = dbManager->addWriteOffRecords(records);
+  for (size_t i = 0; i < records.size(); ++i) {
+    if (i >= saved.size() || !saved[i]) {
+      result.errors.append(
+          QString("Failed to record write-off for product ID %1")
+              .arg(records[i].productId));
+    }
+  }
+}
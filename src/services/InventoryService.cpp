@@ -1,13 +1,114 @@
 #include "services/InventoryService.h"
 #include "exceptions/Exceptions.h"
+#include "managers/DatabaseManager.h"
+#include <QDebug>
 #include <algorithm>
+#include <iterator>
 #include <string>
 
-InventoryService::InventoryService() {}
+InventoryService::InventoryService() : store(nullptr) {}
+
+static std::vector<std::shared_ptr<const Product>>
+readOnly(std::vector<std::shared_ptr<Product>> products) {
+  return std::vector<std::shared_ptr<const Product>>(
+      std::make_move_iterator(products.begin()),
+      std::make_move_iterator(products.end()));
+}
+
+bool InventoryService::attachStore(DatabaseManager *dbManager) {
+  store = dbManager;
+  dirtyIds.clear();
+  removedIds.clear();
+  repository.clear();
+  columns.clear();
+  if (!store) {
+    return true;
+  }
+  if (!store->isConnected()) {
+    qDebug() << "Product store is not connected";
+    return false;
+  }
+
+  for (const auto &product : store->getAllProducts()) {
+    repository.add(std::make_shared<Product>(product));
+    columns.upsert(product);
+  }
+  return true;
+}
+
+bool InventoryService::checkpoint() {
+  if (!store || !hasPendingChanges()) {
+    return true;
+  }
+
+  std::vector<int> ids;
+  std::vector<Product> products;
+  for (int id : dirtyIds) {
+    auto product = repository.findById(id);
+    if (product) {
+      ids.push_back(id);
+      products.push_back(*product);
+    }
+  }
+
+  bool ok = true;
+  std::vector<bool> saved = store->addProducts(products);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (saved[i]) {
+      dirtyIds.erase(ids[i]);
+    } else {
+      ok = false;
+    }
+  }
+
+  for (auto it = removedIds.begin(); it != removedIds.end();) {
+    // A product added and removed between checkpoints never reached the
+    // store, so a failed delete only counts if the record is still there.
+    if (store->deleteProduct(*it) || store->getProduct(*it).getId() == 0) {
+      it = removedIds.erase(it);
+    } else {
+      ok = false;
+      ++it;
+    }
+  }
+
+  if (!ok) {
+    qDebug() << "Inventory checkpoint incomplete, retrying later";
+  }
+  return ok;
+}
+
+void InventoryService::markDirty(int id) {
+  removedIds.erase(id);
+  dirtyIds.insert(id);
+}
+
+void InventoryService::markRemoved(int id) {
+  dirtyIds.erase(id);
+  removedIds.insert(id);
+  columns.remove(id);
+  feed.publish(ChangeEvent::Kind::ProductRemoved, id);
+}
+
+void InventoryService::markStockChanged(const Product &product) {
+  markDirty(product.getId());
+  repository.reindex(product.getId());
+  columns.upsert(product);
+  feed.publish(ChangeEvent::Kind::StockChanged, product.getId(),
+               product.getQuantity());
+}
+
+void InventoryService::markUpserted(const Product &product) {
+  markDirty(product.getId());
+  columns.upsert(product);
+  feed.publish(ChangeEvent::Kind::ProductUpserted, product.getId(),
+               product.getQuantity());
+}
 
 void InventoryService::addProduct(std::shared_ptr<Product> product) {
   try {
     repository.add(product);
+    markUpserted(*product);
   } catch (const ProductException &e) {
     throw;
   }
@@ -20,8 +121,15 @@ void InventoryService::updateProduct(int id, std::shared_ptr<Product> product) {
       throw ProductNotFoundException("Product with ID " + std::to_string(id) +
                                      " not found");
     }
-    repository.remove(id);
-    repository.add(product);
+    if (!repository.replace(id, product)) {
+      throw ProductException("Product with ID " +
+                             std::to_string(product->getId()) +
+                             " already exists");
+    }
+    if (product->getId() != id) {
+      markRemoved(id);
+    }
+    markUpserted(*product);
   } catch (const ProductException &e) {
     throw;
   }
@@ -35,17 +143,19 @@ void InventoryService::deleteProduct(int id) {
                                      " not found");
     }
     repository.remove(id);
+    markRemoved(id);
   } catch (const ProductException &e) {
     throw;
   }
 }
 
-std::shared_ptr<Product> InventoryService::getProduct(int id) const {
+std::shared_ptr<const Product> InventoryService::getProduct(int id) const {
   return repository.findById(id);
 }
 
-std::vector<std::shared_ptr<Product>> InventoryService::getAllProducts() const {
-  return repository.findAll();
+std::vector<std::shared_ptr<const Product>>
+InventoryService::getAllProducts() const {
+  return readOnly(repository.findAll());
 }
 
 void InventoryService::addStock(int id, int quantity) {
@@ -59,6 +169,7 @@ void InventoryService::addStock(int id, int quantity) {
       throw NegativeQuantityException("Stock quantity cannot be negative");
     }
     *product += quantity;
+    markStockChanged(*product);
   } catch (const ProductException &e) {
     throw;
   }
@@ -75,23 +186,43 @@ void InventoryService::removeStock(int id, int quantity) {
       throw NegativeQuantityException("Stock quantity cannot be negative");
     }
     *product -= quantity;
+    markStockChanged(*product);
   } catch (const ProductException &e) {
     throw;
   }
 }
 
-std::vector<std::shared_ptr<Product>>
+std::vector<std::shared_ptr<const Product>>
 InventoryService::searchProducts(const std::string &name) const {
-  return repository.searchByName(name);
+  return readOnly(repository.findByIds(columns.idsWithNameContaining(name)));
 }
 
-std::vector<std::shared_ptr<Product>>
+std::vector<std::shared_ptr<const Product>>
 InventoryService::filterByCategory(const std::string &category) const {
-  return repository.searchByCategory(category);
+  return readOnly(repository.findByIds(columns.idsInCategory(category)));
+}
+
+std::vector<std::shared_ptr<const Product>>
+InventoryService::filterByPriceRange(double minPrice, double maxPrice) const {
+  return readOnly(repository.findByPriceRange(minPrice, maxPrice));
+}
+
+std::vector<std::shared_ptr<const Product>>
+InventoryService::getLowStockProducts(int threshold) const {
+  if (threshold <= 0) {
+    return {};
+  }
+  return readOnly(repository.findByQuantityRange(0, threshold - 1));
+}
+
+std::vector<std::shared_ptr<const Product>>
+InventoryService::getTopProductsByQuantity(size_t count) const {
+  return readOnly(repository.orderedBy(
+      ProductRepository<Product>::SortKey::Quantity, count, true));
 }
 
 double InventoryService::calculateTotalInventoryValue() const {
-  return repository.calculateTotalInventoryValue();
+  return columns.totalValue();
 }
 
 double InventoryService::calculateTotalInventoryCost() const {
@@ -103,13 +234,17 @@ int InventoryService::getTotalProductCount() const {
 }
 
 int InventoryService::getTotalQuantity() const {
-  int total = 0;
-  for (const auto &product : repository) {
-    if (product) {
-      total += product->getQuantity();
-    }
-  }
-  return total;
+  return columns.totalQuantity();
+}
+
+InventoryService::CategoryTotals
+InventoryService::getCategoryTotals(const std::string &category) const {
+  return columns.categoryTotals(category);
+}
+
+std::vector<std::pair<std::string, InventoryService::CategoryTotals>>
+InventoryService::getCategorySummary() const {
+  return columns.categorySummary();
 }
 
 void InventoryService::writeOffProduct(int id, int quantity,
@@ -162,6 +297,7 @@ void InventoryService::writeOffProduct(int id, int quantity,
     }
 
     product->setQuantity(newQuantity);
+    markStockChanged(*product);
   } catch (const NegativeQuantityException &e) {
 
     throw;
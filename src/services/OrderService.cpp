@@ -1,26 +1,60 @@
 #include "services/OrderService.h"
+#include <QPromise>
+#include <algorithm>
 
-OrderService::Result OrderService::createOrder(InventoryService &inventory,
-                                               DatabaseManager &db,
-                                               const Order &order) {
+OrderService::Result OrderService::createOrder(DatabaseManager &db,
+                                               InventoryService &inventory,
+                                               Order &order) {
   Result result;
+  if (order.getId() == 0) {
+    int id = db.nextOrderId();
+    if (id < 0) {
+      QPromise<bool> failed;
+      failed.start();
+      failed.addResult(false);
+      failed.finish();
+      result.saved = failed.future();
+      return result;
+    }
+    order.setId(id);
+  }
 
-  if (!db.addOrder(order)) {
-    result.saved = false;
-    return result;
+  result.stockChanges = applyStockChanges(inventory, order);
+  std::vector<Product> products;
+  for (const auto &change : result.stockChanges) {
+    if (auto product = inventory.getProduct(change.productId)) {
+      products.push_back(*product);
+    }
   }
 
+  result.saved = db.addOrderWithStockAsync(order, std::move(products));
+  result.totalAmount = order.getTotalAmount();
+  return result;
+}
+
+std::vector<OrderService::StockChange>
+OrderService::applyStockChanges(InventoryService &inventory,
+                                const Order &order) {
+  std::vector<StockChange> changes;
   for (const auto &item : order.getItems()) {
     auto productPtr = inventory.getProduct(item.productId);
     if (productPtr) {
-      int newQuantity = productPtr->getQuantity() - item.quantity;
-      if (newQuantity < 0)
-        newQuantity = 0;
-      productPtr->setQuantity(newQuantity);
+      // Stock never goes below zero; only what is on hand is removed.
+      int quantity = std::min(item.quantity, productPtr->getQuantity());
+      if (quantity > 0) {
+        inventory.removeStock(item.productId, quantity);
+        changes.push_back({item.productId, quantity});
+      }
     }
   }
+  return changes;
+}
 
-  result.saved = true;
-  result.totalAmount = order.getTotalAmount();
-  return result;
+void OrderService::revertStockChanges(InventoryService &inventory,
+                                      const std::vector<StockChange> &changes) {
+  for (const auto &change : changes) {
+    if (inventory.getProduct(change.productId)) {
+      inventory.addStock(change.productId, change.quantity);
+    }
+  }
 }
@@ -1,13 +1,21 @@
 #include "services/ProductFilterService.h"
 #include <algorithm>
 
-std::vector<std::shared_ptr<Product>>
+static bool isAllCategories(const QString &category) {
+  return category == "All Categories" || category.isEmpty();
+}
+
+static bool nameContains(const Product &product, const QString &lowered) {
+  return QString::fromStdString(product.getName()).toLower().contains(lowered);
+}
+
+std::vector<std::shared_ptr<const Product>>
 ProductFilterService::filterProducts(const InventoryService &inventory,
                                      const QString &category,
                                      const QString &searchText) {
-  std::vector<std::shared_ptr<Product>> products;
+  std::vector<std::shared_ptr<const Product>> products;
 
-  if (category == "All Categories" || category.isEmpty()) {
+  if (isAllCategories(category)) {
     products = inventory.getAllProducts();
   } else {
     products = inventory.filterByCategory(category.toStdString());
@@ -15,19 +23,22 @@ ProductFilterService::filterProducts(const InventoryService &inventory,
 
   if (!searchText.trimmed().isEmpty()) {
     QString lowered = searchText.trimmed().toLower();
-    std::vector<std::shared_ptr<Product>> filtered;
-    filtered.reserve(products.size());
-
-    for (const auto &p : products) {
-      if (!p)
-        continue;
-      QString productName = QString::fromStdString(p->getName()).toLower();
-      if (productName.contains(lowered)) {
-        filtered.push_back(p);
-      }
-    }
-    products.swap(filtered);
+    std::erase_if(products,
+                  [&lowered](const std::shared_ptr<const Product> &p) {
+                    return !p || !nameContains(*p, lowered);
+                  });
   }
 
   return products;
 }
+
+bool ProductFilterService::matches(const Product &product,
+                                   const QString &category,
+                                   const QString &searchText) {
+  if (!isAllCategories(category) &&
+      product.getCategory() != category.toStdString()) {
+    return false;
+  }
+  QString trimmed = searchText.trimmed();
+  return trimmed.isEmpty() || nameContains(product, trimmed.toLower());
+}
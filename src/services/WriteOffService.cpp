@@ -5,10 +5,9 @@ WriteOffService::Result WriteOffService::writeOffProduct(
     InventoryService &inventory, DatabaseManager *dbManager, int productId,
     int quantity, const QString &reason, const QString &productName) {
 
-  inventory.writeOffProduct(productId, quantity, reason.toStdString());
-
+  // Valued before the write-off lowers the stock it is checked against.
   auto productPtr = inventory.getProduct(productId);
-  WriteOffService::Result result{0.0, false};
+  WriteOffService::Result result{0.0, QFuture<bool>()};
 
   if (productPtr) {
 
@@ -16,14 +15,12 @@ WriteOffService::Result WriteOffService::writeOffProduct(
         WriteOffCalculator::calculateWriteOffValue(*productPtr, quantity);
   }
 
+  inventory.writeOffProduct(productId, quantity, reason.toStdString());
+
   if (dbManager && result.writeOffValue >= 0.0) {
-    try {
-      result.dbRecordSaved = dbManager->addWriteOffRecord(
-          productId, quantity, result.writeOffValue, reason,
-          productName.isEmpty() ? QString("Unknown Product") : productName);
-    } catch (...) {
-      result.dbRecordSaved = false;
-    }
+    result.dbRecordSaved = dbManager->addWriteOffRecordAsync(
+        productId, quantity, result.writeOffValue, reason,
+        productName.isEmpty() ? QString("Unknown Product") : productName);
   }
 
   return result;
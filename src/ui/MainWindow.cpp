@@ -5,7 +5,6 @@
 #include "services/InventoryAdjustmentService.h"
 #include "services/InventoryService.h"
 #include "services/OrderService.h"
-#include "services/ProductFilterService.h"
 #include "services/ProductValidator.h"
 #include "services/WriteOffService.h"
 #include "ui/delegates/ActionsDelegate.h"
@@ -22,10 +21,12 @@
 #include <QChartView>
 #include <QColor>
 #include <QComboBox>
+#include <QDebug>
 #include <QDir>
 #include <QFile>
 #include <QFileDialog>
 #include <QFont>
+#include <QFutureWatcher>
 #include <QFrame>
 #include <QGroupBox>
 #include <QHBoxLayout>
@@ -47,19 +48,23 @@
 #include <QTableWidget>
 #include <QTextEdit>
 #include <QTextStream>
+#include <QTimer>
 #include <QTreeWidget>
 #include <QTreeWidgetItem>
 #include <QVBoxLayout>
 #include <QValueAxis>
 #include <algorithm>
 #include <cctype>
+#include <set>
 #include <string>
 
+static const int CHECKPOINT_INTERVAL_MS = 5000;
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), inventoryManager(new InventoryService()) {
 
   dbManager = DatabaseManager::getInstance();
+  dbManager->setResidentCacheEnabled(true);
   dbManager->initializeDatabase();
 
   QString dataPath =
@@ -70,31 +75,97 @@ MainWindow::MainWindow(QWidget *parent)
   }
   dataFilePath = dataPath + "/inventory.dat";
 
-  if (QFile::exists(dataFilePath)) {
-    FileManager::loadFromBinary(*inventoryManager, dataFilePath.toStdString());
-  }
-
-  auto products = inventoryManager->getAllProducts();
-  int maxId = 0;
-  for (const auto &product : products) {
-    if (product && product->getId() > maxId) {
-      maxId = product->getId();
-    }
-  }
-  if (maxId > 0) {
-    Product::setNextId(maxId);
-  }
+  inventoryManager->attachStore(dbManager);
+  importLegacyInventory();
 
   writeOffsReportTextEdit = nullptr;
   setupUI();
   productModel->refresh();
+  reportLoadDamage();
+
+  checkpointTimer = new QTimer(this);
+  connect(checkpointTimer, &QTimer::timeout, this,
+          [this]() { inventoryManager->checkpoint(); });
+  checkpointTimer->start(CHECKPOINT_INTERVAL_MS);
 }
 
 MainWindow::~MainWindow() {
-  FileManager::saveToBinary(*inventoryManager, dataFilePath.toStdString());
+  checkpointTimer->stop();
+  inventoryManager->checkpoint();
+  dbManager->flush();
   delete inventoryManager;
 }
 
+void MainWindow::importLegacyInventory() {
+  // inventory.dat used to be the authoritative copy of the products: edits,
+  // deletes and stock changes were only ever saved there. It is reconciled
+  // into the product store once, then set aside.
+  if (!QFile::exists(dataFilePath)) {
+    return;
+  }
+
+  std::vector<Product> saved;
+  if (!FileManager::readBinary(dataFilePath.toStdString(), saved)) {
+    qDebug() << "Cannot read legacy inventory:" << dataFilePath;
+    return;
+  }
+
+  try {
+    std::set<int> savedIds;
+    for (const auto &product : saved) {
+      savedIds.insert(product.getId());
+      auto copy = std::make_shared<Product>(product);
+      if (inventoryManager->getProduct(product.getId())) {
+        inventoryManager->updateProduct(product.getId(), copy);
+      } else {
+        inventoryManager->addProduct(copy);
+      }
+    }
+    for (const auto &product : inventoryManager->getAllProducts()) {
+      if (!savedIds.count(product->getId())) {
+        inventoryManager->deleteProduct(product->getId());
+      }
+    }
+  } catch (const std::exception &e) {
+    qDebug() << "Legacy inventory import failed:" << e.what();
+    return;
+  }
+
+  if (inventoryManager->checkpoint()) {
+    QFile::rename(dataFilePath, dataFilePath + ".imported");
+  }
+}
+
+void MainWindow::reportLoadDamage() {
+  // Loading steps over corrupt records instead of stopping at them, so what
+  // they held is missing from the lists; say so once at startup.
+  const std::pair<DatabaseManager::Store, QString> stores[] = {
+      {DatabaseManager::Store::Products, "Products"},
+      {DatabaseManager::Store::Orders, "Orders"},
+      {DatabaseManager::Store::WriteOffs, "Write-offs"}};
+
+  QStringList damage;
+  for (const auto &store : stores) {
+    LoadReport report = dbManager->loadReport(store.first);
+    if (report.isClean()) {
+      continue;
+    }
+    damage << QString("%1: %2 corrupt record(s) skipped (%3 bytes), %4 "
+                      "unreadable bytes at the end")
+                  .arg(store.second)
+                  .arg(report.skippedRanges)
+                  .arg(report.skippedBytes)
+                  .arg(report.tailBytes);
+  }
+
+  if (!damage.isEmpty()) {
+    QMessageBox::warning(this, "Damaged Data",
+                         "Some stored records could not be read and were "
+                         "skipped:\n\n" +
+                             damage.join("\n"));
+  }
+}
+
 QString MainWindow::updateWriteOffsReport() {
   if (!inventoryManager) {
     return QString();
@@ -418,6 +489,10 @@ void MainWindow::refreshTable() {
 
 void MainWindow::addProduct() {
   ProductDialog dialog(this);
+  int suggestedId = dbManager->nextProductId();
+  if (suggestedId > 0) {
+    dialog.setSuggestedId(suggestedId);
+  }
   if (dialog.exec() == QDialog::Accepted) {
     try {
       Product product = dialog.getProduct();
@@ -431,11 +506,7 @@ void MainWindow::addProduct() {
 
       auto productPtr = std::make_shared<Product>(product);
       inventoryManager->addProduct(productPtr);
-
-      dbManager->addProduct(product);
-
-      productModel->refresh();
-      FileManager::saveToBinary(*inventoryManager, dataFilePath.toStdString());
+      inventoryManager->checkpoint();
 
       QMessageBox::information(
           this, "Success",
@@ -461,9 +532,7 @@ void MainWindow::generateReport() {
 void MainWindow::openInventory() {
   InventoryDialog dialog(inventoryManager, this);
   if (dialog.exec() == QDialog::Accepted) {
-    productModel->refresh();
-
-    FileManager::saveToBinary(*inventoryManager, dataFilePath.toStdString());
+    inventoryManager->checkpoint();
   }
 }
 
@@ -490,26 +559,29 @@ void MainWindow::createOrder() {
     Order order = dialog.getOrder();
 
     OrderService::Result result =
-        OrderService::createOrder(*inventoryManager, *dbManager, order);
-
-    if (!result.saved) {
-      QMessageBox::warning(this, "Error", "Failed to save order!");
-      return;
-    }
-
-    FileManager::saveToBinary(*inventoryManager, dataFilePath.toStdString());
-
-    if (productModel) {
-      productModel->refresh();
-    }
+        OrderService::createOrder(*dbManager, *inventoryManager, order);
+
+    auto *watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this,
+            [this, watcher, order, result]() {
+              watcher->deleteLater();
+              if (!watcher->result()) {
+                OrderService::revertStockChanges(*inventoryManager,
+                                                 result.stockChanges);
+                inventoryManager->checkpoint();
+                QMessageBox::warning(this, "Error", "Failed to save order!");
+                return;
+              }
 
-    saveOrderHistoryToTxt(order);
+              saveOrderHistoryToTxt(order);
 
-    QMessageBox::information(
-        this, "Success",
-        QString("Order #%1 created successfully!\nAmount: $%2")
-            .arg(order.getId())
-            .arg(result.totalAmount, 0, 'f', 2));
+              QMessageBox::information(
+                  this, "Success",
+                  QString("Order #%1 created successfully!\nAmount: $%2")
+                      .arg(order.getId())
+                      .arg(result.totalAmount, 0, 'f', 2));
+            });
+    watcher->setFuture(result.saved);
   }
 }
 
@@ -589,13 +661,6 @@ void MainWindow::editOrder(int orderId) {
       QMessageBox::information(
           this, "Success",
           QString("Order #%1 updated successfully!").arg(updatedOrder.getId()));
-
-      QLayoutItem *child;
-      while ((child = contentWidget->layout()->takeAt(0)) != nullptr) {
-        delete child->widget();
-        delete child;
-      }
-      contentWidget->layout()->addWidget(createOrdersSection());
     } else {
       QMessageBox::warning(this, "Error", "Failed to update order!");
     }
@@ -631,20 +696,8 @@ void MainWindow::applyFilters() {
     return;
   }
 
-  QString category = categoryComboBox->currentText();
-  QString searchText = searchLineEdit->text().trimmed();
-
-  auto products = ProductFilterService::filterProducts(*inventoryManager,
-                                                       category, searchText);
-
-  std::vector<Product> productList;
-  productList.reserve(products.size());
-  for (const auto &p : products) {
-    if (p) {
-      productList.push_back(*p);
-    }
-  }
-  productModel->setProducts(productList);
+  productModel->setFilter(categoryComboBox->currentText(),
+                          searchLineEdit->text().trimmed());
 }
 
 void MainWindow::onSelectionChanged() {
@@ -664,10 +717,7 @@ void MainWindow::editProductByRow(int row) {
 
       auto productPtr = std::make_shared<Product>(updatedProduct);
       inventoryManager->updateProduct(product.getId(), productPtr);
-
-      productModel->refresh();
-
-      FileManager::saveToBinary(*inventoryManager, dataFilePath.toStdString());
+      inventoryManager->checkpoint();
 
       QMessageBox::information(this, "Success",
                                "Product updated successfully!");
@@ -693,10 +743,7 @@ void MainWindow::deleteProductByRow(int row) {
   if (ret == QMessageBox::Yes) {
     try {
       inventoryManager->deleteProduct(product.getId());
-
-      productModel->refresh();
-
-      FileManager::saveToBinary(*inventoryManager, dataFilePath.toStdString());
+      inventoryManager->checkpoint();
 
       QMessageBox::information(this, "Success",
                                "Product deleted successfully!");
@@ -759,12 +806,11 @@ void MainWindow::writeOffProductByRow(int row) {
       bool saveSuccess = false;
       try {
         if (inventoryManager) {
-          saveSuccess = FileManager::saveToBinary(*inventoryManager,
-                                                  dataFilePath.toStdString());
+          saveSuccess = inventoryManager->checkpoint();
           if (!saveSuccess) {
             QMessageBox::warning(
                 this, "Warning",
-                "Product written off, but failed to save to file.");
+                "Product written off, but failed to save the change.");
           }
         }
       } catch (const std::exception &e) {
@@ -779,12 +825,7 @@ void MainWindow::writeOffProductByRow(int row) {
       }
 
       try {
-        if (productModel && inventoryManager) {
-          productModel->refresh();
-        }
         if (tableView) {
-          tableView->viewport()->update();
-          tableView->update();
           tableView->resizeColumnsToContents();
 
           QApplication::processEvents();
@@ -887,79 +928,108 @@ QWidget *MainWindow::createOrdersSection() {
   ordersTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
   ordersTable->setAlternatingRowColors(true);
 
-  auto populateOrdersTable = [this, ordersTable](QTableWidget *table) {
-    table->setRowCount(0);
-    auto orders = dbManager->getAllOrders();
-    table->setRowCount(orders.size());
-    for (size_t i = 0; i < orders.size(); ++i) {
-      const auto &order = orders[i];
-      table->setItem(i, 0,
-                     new QTableWidgetItem(QString::number(order.getId())));
-      table->setItem(i, 1, new QTableWidgetItem(order.getCompanyName()));
-      table->setItem(i, 2, new QTableWidgetItem(order.getContactPerson()));
-      table->setItem(i, 3, new QTableWidgetItem(order.getOrderTypeString()));
-      table->setItem(
-          i, 4,
-          new QTableWidgetItem(order.getOrderDate().toString("yyyy-MM-dd")));
-      table->setItem(i, 5,
-                     new QTableWidgetItem(QString("$%1").arg(
-                         order.getTotalAmount(), 0, 'f', 2)));
-
-      QWidget *actionsWidget = new QWidget();
-      QHBoxLayout *actionsLayout = new QHBoxLayout(actionsWidget);
-      actionsLayout->setContentsMargins(5, 2, 5, 2);
-      actionsLayout->setSpacing(5);
-
-      QPushButton *editBtn = new QPushButton("Edit", actionsWidget);
-      QString editBtnStyle = getPrimaryButtonStyle();
-      editBtnStyle.replace("padding: 10px 20px;", "padding: 5px 10px;");
-      editBtnStyle.replace("font-size: 14px;", "font-size: 12px;");
-      editBtnStyle.replace("border-radius: 5px;", "border-radius: 3px;");
-      editBtn->setStyleSheet(editBtnStyle);
-
-      QPushButton *deleteBtn = new QPushButton("Delete", actionsWidget);
-      QString deleteBtnStyle = getDangerButtonStyle();
-      deleteBtnStyle.replace("padding: 10px 20px;", "padding: 5px 10px;");
-      deleteBtnStyle.replace("font-size: 14px;", "font-size: 12px;");
-      deleteBtnStyle.replace("border-radius: 5px;", "border-radius: 3px;");
-      deleteBtn->setStyleSheet(deleteBtnStyle);
-
-      actionsLayout->addWidget(editBtn);
-      actionsLayout->addWidget(deleteBtn);
-      actionsLayout->addStretch();
-
-      int orderId = order.getId();
-      connect(editBtn, &QPushButton::clicked, this,
-              [this, orderId]() { editOrder(orderId); });
-
-      connect(deleteBtn, &QPushButton::clicked, this, [this, orderId]() {
-        int ret = QMessageBox::question(
-            this, "Confirm Delete",
-            QString("Are you sure you want to delete order #%1?").arg(orderId),
-            QMessageBox::Yes | QMessageBox::No);
-
-        if (ret == QMessageBox::Yes) {
-          if (dbManager->deleteOrder(orderId)) {
-            QMessageBox::information(this, "Success",
-                                     "Order deleted successfully!");
-
-            QLayoutItem *child;
-            while ((child = contentWidget->layout()->takeAt(0)) != nullptr) {
-              delete child->widget();
-              delete child;
-            }
-            contentWidget->layout()->addWidget(createOrdersSection());
-          } else {
-            QMessageBox::warning(this, "Error", "Failed to delete order!");
-          }
+  auto fillOrderRow = [this](QTableWidget *table, int row,
+                             const OrderHeader &order) {
+    table->setItem(row, 0, new QTableWidgetItem(QString::number(order.id)));
+    table->setItem(row, 1, new QTableWidgetItem(order.companyName));
+    table->setItem(row, 2, new QTableWidgetItem(order.contactPerson));
+    table->setItem(row, 3, new QTableWidgetItem(order.getOrderTypeString()));
+    table->setItem(
+        row, 4, new QTableWidgetItem(order.orderDate.toString("yyyy-MM-dd")));
+    table->setItem(row, 5,
+                   new QTableWidgetItem(
+                       QString("$%1").arg(order.totalAmount, 0, 'f', 2)));
+
+    QWidget *actionsWidget = new QWidget();
+    QHBoxLayout *actionsLayout = new QHBoxLayout(actionsWidget);
+    actionsLayout->setContentsMargins(5, 2, 5, 2);
+    actionsLayout->setSpacing(5);
+
+    QPushButton *editBtn = new QPushButton("Edit", actionsWidget);
+    QString editBtnStyle = getPrimaryButtonStyle();
+    editBtnStyle.replace("padding: 10px 20px;", "padding: 5px 10px;");
+    editBtnStyle.replace("font-size: 14px;", "font-size: 12px;");
+    editBtnStyle.replace("border-radius: 5px;", "border-radius: 3px;");
+    editBtn->setStyleSheet(editBtnStyle);
+
+    QPushButton *deleteBtn = new QPushButton("Delete", actionsWidget);
+    QString deleteBtnStyle = getDangerButtonStyle();
+    deleteBtnStyle.replace("padding: 10px 20px;", "padding: 5px 10px;");
+    deleteBtnStyle.replace("font-size: 14px;", "font-size: 12px;");
+    deleteBtnStyle.replace("border-radius: 5px;", "border-radius: 3px;");
+    deleteBtn->setStyleSheet(deleteBtnStyle);
+
+    actionsLayout->addWidget(editBtn);
+    actionsLayout->addWidget(deleteBtn);
+    actionsLayout->addStretch();
+
+    int orderId = order.id;
+    connect(editBtn, &QPushButton::clicked, this,
+            [this, orderId]() { editOrder(orderId); });
+
+    // The table drops the row itself when the order feed reports the delete.
+    connect(deleteBtn, &QPushButton::clicked, this, [this, orderId]() {
+      int ret = QMessageBox::question(
+          this, "Confirm Delete",
+          QString("Are you sure you want to delete order #%1?").arg(orderId),
+          QMessageBox::Yes | QMessageBox::No);
+
+      if (ret == QMessageBox::Yes) {
+        if (dbManager->deleteOrder(orderId)) {
+          QMessageBox::information(this, "Success",
+                                   "Order deleted successfully!");
+        } else {
+          QMessageBox::warning(this, "Error", "Failed to delete order!");
         }
-      });
+      }
+    });
 
-      table->setCellWidget(i, 6, actionsWidget);
-    }
+    table->setCellWidget(row, 6, actionsWidget);
   };
 
-  populateOrdersTable(ordersTable);
+  auto orders = dbManager->getOrderHeaders();
+  ordersTable->setRowCount(orders.size());
+  for (size_t i = 0; i < orders.size(); ++i) {
+    fillOrderRow(ordersTable, i, orders[i]);
+  }
+
+  // Keep the table in step with the order store one row at a time instead of
+  // rebuilding the whole section after every change.
+  connect(dbManager->changes(), &ChangeFeed::changed, ordersTable,
+          [this, ordersTable, fillOrderRow](const ChangeEvent &event) {
+            if (event.kind != ChangeEvent::Kind::OrderAdded &&
+                event.kind != ChangeEvent::Kind::OrderUpdated &&
+                event.kind != ChangeEvent::Kind::OrderDeleted) {
+              return;
+            }
+
+            int row = -1;
+            QString key = QString::number(event.id);
+            for (int i = 0; i < ordersTable->rowCount(); ++i) {
+              QTableWidgetItem *item = ordersTable->item(i, 0);
+              if (item && item->text() == key) {
+                row = i;
+                break;
+              }
+            }
+
+            if (event.kind == ChangeEvent::Kind::OrderDeleted) {
+              if (row >= 0) {
+                ordersTable->removeRow(row);
+              }
+              return;
+            }
+
+            Order order = dbManager->getOrder(event.id);
+            if (order.getId() == 0) {
+              return;
+            }
+            if (row < 0) {
+              row = ordersTable->rowCount();
+              ordersTable->insertRow(row);
+            }
+            fillOrderRow(ordersTable, row, OrderHeader(order));
+          });
 
   ordersTable->horizontalHeader()->setStretchLastSection(false);
   ordersTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
@@ -1100,37 +1170,26 @@ QWidget *MainWindow::createInventorySection() {
         }
 
         InventoryAdjustmentService::Result result;
+        std::vector<InventoryAdjustmentService::Adjustment> adjustments;
+        adjustments.reserve(inventoryModel->rowCount());
 
         for (int i = 0; i < inventoryModel->rowCount(); ++i) {
-          int id = inventoryModel->item(i, 0)->text().toInt();
-          int currentQty = inventoryModel->item(i, 3)->text().toInt();
-          int actualQty = inventoryModel->item(i, 4)->text().toInt();
-
-          try {
-            InventoryAdjustmentService::applyAdjustment(
-                *inventoryManager, dbManager, id, currentQty, actualQty,
-                result);
-          } catch (const ProductException &e) {
-            QMessageBox::warning(this, "Error",
-                                 QString("Failed to update product ID %1: %2")
-                                     .arg(id)
-                                     .arg(QString::fromStdString(e.what())));
-          } catch (const std::exception &e) {
-            QMessageBox::warning(this, "Error",
-                                 QString("Failed to update product ID %1: %2")
-                                     .arg(id)
-                                     .arg(e.what()));
-          }
+          InventoryAdjustmentService::Adjustment adjustment;
+          adjustment.id = inventoryModel->item(i, 0)->text().toInt();
+          adjustment.currentQty = inventoryModel->item(i, 3)->text().toInt();
+          adjustment.actualQty = inventoryModel->item(i, 4)->text().toInt();
+          adjustments.push_back(adjustment);
+        }
+
+        InventoryAdjustmentService::applyAdjustments(
+            *inventoryManager, dbManager, adjustments, result);
+        for (const QString &error : result.errors) {
+          QMessageBox::warning(this, "Error", error);
         }
 
         if (result.itemsUpdated > 0) {
 
-          FileManager::saveToBinary(*inventoryManager,
-                                    dataFilePath.toStdString());
-
-          if (productModel) {
-            productModel->refresh();
-          }
+          inventoryManager->checkpoint();
 
           QMessageBox::information(this, "Success",
                                    QString("Inventory saved successfully!\n"
@@ -1174,6 +1233,9 @@ QWidget *MainWindow::createInventorySection() {
 }
 
 QWidget *MainWindow::createReportsSection() {
+  // Totals and charts must include orders still in the write queue.
+  dbManager->awaitWrites(DatabaseManager::Store::Orders);
+
   QWidget *sectionWidget = new QWidget(this);
   QHBoxLayout *mainLayout = new QHBoxLayout(sectionWidget);
   mainLayout->setSpacing(0);
@@ -1569,19 +1631,16 @@ QWidget *MainWindow::createReportsSection() {
 }
 
 double MainWindow::calculateTotalSales() {
-  auto orders = dbManager->getAllOrders();
   double total = 0.0;
-  for (const auto &order : orders) {
-    total += order.getTotalAmount();
-  }
+  dbManager->forEachOrder(
+      [&total](const Order &order) { total += order.getTotalAmount(); });
   return total;
 }
 
 QMap<QString, double> MainWindow::getCategorySalesData() {
   QMap<QString, double> categorySales;
-  auto orders = dbManager->getAllOrders();
 
-  for (const auto &order : orders) {
+  dbManager->forEachOrder([&categorySales](const Order &order) {
     const auto &items = order.getItems();
     for (const auto &item : items) {
       QString category = item.category;
@@ -1590,22 +1649,21 @@ QMap<QString, double> MainWindow::getCategorySalesData() {
       }
       categorySales[category] += item.totalPrice;
     }
-  }
+  });
 
   return categorySales;
 }
 
 QList<QPair<QString, double>> MainWindow::getTopCompaniesData(int topCount) {
   QMap<QString, double> companySales;
-  auto orders = dbManager->getAllOrders();
 
-  for (const auto &order : orders) {
+  dbManager->forEachOrder([&companySales](const Order &order) {
     QString companyName = order.getCompanyName();
     if (companyName.isEmpty()) {
       companyName = "Unknown";
     }
     companySales[companyName] += order.getTotalAmount();
-  }
+  });
 
   QList<QPair<QString, double>> companyList;
   for (auto it = companySales.begin(); it != companySales.end(); ++it) {
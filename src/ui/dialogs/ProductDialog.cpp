@@ -76,6 +76,12 @@ void ProductDialog::populateFields(const Product &product) {
   unitPriceSpinBox->setValue(product.getUnitPrice());
 }
 
+void ProductDialog::setSuggestedId(int id) {
+  if (!editMode) {
+    idSpinBox->setValue(id);
+  }
+}
+
 Product ProductDialog::getProduct() const {
   try {
     std::string name = nameEdit->text().toStdString();
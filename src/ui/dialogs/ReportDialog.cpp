@@ -77,6 +77,16 @@ void ReportDialog::generateInventoryReport() {
   report += QString("Total Quantity: %1\n\n")
                 .arg(inventoryManager.getTotalQuantity());
 
+  report += "=== BY CATEGORY ===\n\n";
+  for (const auto &[category, totals] : inventoryManager.getCategorySummary()) {
+    report += QString("%1: %2 products, %3 units, $%4\n")
+                  .arg(QString::fromStdString(category))
+                  .arg(totals.productCount)
+                  .arg(totals.totalQuantity)
+                  .arg(QString::number(totals.totalValue, 'f', 2));
+  }
+  report += "\n";
+
   report += "=== PRODUCT LIST ===\n\n";
   auto products = inventoryManager.getAllProducts();
   for (const auto &product : products) {
@@ -50,6 +50,8 @@ void SalesReportDialog::setupUI() {
           &SalesReportDialog::generateReport);
   connect(endDateEdit, &QDateEdit::dateChanged, this,
           &SalesReportDialog::generateReport);
+  connect(companyLineEdit, &QLineEdit::textChanged, this,
+          &SalesReportDialog::generateReport);
 }
 
 QGroupBox *SalesReportDialog::createFiltersGroupBox() {
@@ -77,6 +79,12 @@ QGroupBox *SalesReportDialog::createFiltersGroupBox() {
   endDateEdit->setCalendarPopup(true);
   layout->addWidget(endDateEdit);
 
+  layout->addWidget(new QLabel("Company:", this));
+  companyLineEdit = new QLineEdit(this);
+  companyLineEdit->setPlaceholderText("Company name");
+  companyLineEdit->setEnabled(false);
+  layout->addWidget(companyLineEdit);
+
   layout->addStretch();
 
   return groupBox;
@@ -137,7 +145,7 @@ void SalesReportDialog::setupReportTable() {}
 void SalesReportDialog::setupStatistics() {}
 
 void SalesReportDialog::onReportTypeChanged(int index) {
-  Q_UNUSED(index);
+  companyLineEdit->setEnabled(index == 3);
   generateReport();
 }
 
@@ -147,25 +155,29 @@ void SalesReportDialog::generateReport() {
   QDate endDate = endDateEdit->date();
 
   currentOrders.clear();
+  dbManager->awaitWrites(DatabaseManager::Store::Orders);
 
   switch (reportType) {
   case 0:
-    currentOrders = dbManager->getOrdersByDateRange(startDate, endDate);
+    currentOrders = dbManager->getOrderHeadersByDateRange(startDate, endDate);
     break;
   case 1:
-    currentOrders = dbManager->getOrdersByType(OrderType::RETAIL);
+    currentOrders = dbManager->getOrderHeadersByType(OrderType::RETAIL);
     break;
   case 2:
-    currentOrders = dbManager->getOrdersByType(OrderType::WHOLESALE);
+    currentOrders = dbManager->getOrderHeadersByType(OrderType::WHOLESALE);
     break;
   case 3:
-    currentOrders = dbManager->getAllOrders();
+    currentOrders = companyLineEdit->text().trimmed().isEmpty()
+                        ? dbManager->getOrderHeaders()
+                        : dbManager->getOrderHeadersByCompany(
+                              companyLineEdit->text().trimmed());
     break;
   case 4:
-    currentOrders = dbManager->getOrdersByDateRange(startDate, endDate);
+    currentOrders = dbManager->getOrderHeadersByDateRange(startDate, endDate);
     break;
   default:
-    currentOrders = dbManager->getAllOrders();
+    currentOrders = dbManager->getOrderHeaders();
     break;
   }
 
@@ -181,20 +193,18 @@ void SalesReportDialog::refreshReport() {
     reportTable->insertRow(row);
 
     reportTable->setItem(row, 0,
-                         new QTableWidgetItem(QString::number(order.getId())));
-    reportTable->setItem(row, 1, new QTableWidgetItem(order.getCompanyName()));
-    reportTable->setItem(row, 2,
-                         new QTableWidgetItem(order.getContactPerson()));
+                         new QTableWidgetItem(QString::number(order.id)));
+    reportTable->setItem(row, 1, new QTableWidgetItem(order.companyName));
+    reportTable->setItem(row, 2, new QTableWidgetItem(order.contactPerson));
     reportTable->setItem(row, 3,
                          new QTableWidgetItem(order.getOrderTypeString()));
     reportTable->setItem(
-        row, 4,
-        new QTableWidgetItem(order.getOrderDate().toString("MM/dd/yyyy")));
+        row, 4, new QTableWidgetItem(order.orderDate.toString("MM/dd/yyyy")));
     reportTable->setItem(
-        row, 5, new QTableWidgetItem(QString::number(order.getItems().size())));
+        row, 5, new QTableWidgetItem(QString::number(order.itemCount)));
     reportTable->setItem(row, 6,
                          new QTableWidgetItem(QString("$%1").arg(
-                             order.getTotalAmount(), 0, 'f', 2)));
+                             order.totalAmount, 0, 'f', 2)));
   }
 
   reportTable->resizeColumnsToContents();
@@ -209,15 +219,15 @@ void SalesReportDialog::calculateStatistics() {
   int wholesaleCount = 0;
 
   for (const auto &order : currentOrders) {
-    if (order.getOrderType() == OrderType::RETAIL) {
-      totalRetail += order.getTotalAmount();
+    if (order.orderType == OrderType::RETAIL) {
+      totalRetail += order.totalAmount;
       retailCount++;
     } else {
-      totalWholesale += order.getTotalAmount();
+      totalWholesale += order.totalAmount;
       wholesaleCount++;
     }
-    totalAmount += order.getTotalAmount();
-    totalDiscount += order.getTotalDiscount();
+    totalAmount += order.totalAmount;
+    totalDiscount += order.totalDiscount;
   }
 
   totalRetailLabel->setText(QString("Retail: $%1 (%2 orders)")
@@ -259,8 +269,15 @@ void SalesReportDialog::exportReport() {
   out << totalAmountLabel->text() << "\n";
   out << totalDiscountLabel->text() << "\n\n";
 
+  // Items are only needed here, so full orders are read for the export alone.
+  std::vector<int> ids;
+  ids.reserve(currentOrders.size());
+  for (const auto &header : currentOrders) {
+    ids.push_back(header.id);
+  }
+
   out << "=== ORDER DETAILS ===\n\n";
-  for (const auto &order : currentOrders) {
+  for (const auto &order : dbManager->getOrders(ids)) {
     out << QString("Order #%1\n").arg(order.getId());
     out << QString("Company: %1\n").arg(order.getCompanyName());
     out << QString("Contact: %1\n").arg(order.getContactPerson());
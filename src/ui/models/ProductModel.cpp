@@ -1,10 +1,16 @@
 #include "ui/models/ProductModel.h"
+#include "services/ProductFilterService.h"
 #include <QColor>
 #include <QDate>
 
 ProductModel::ProductModel(InventoryService* inventoryManager, QObject* parent)
-    : QAbstractTableModel(parent), inventoryManager(inventoryManager) {
+    : QAbstractTableModel(parent), fixedList(false),
+      inventoryManager(inventoryManager), lastSequence(0) {
     refresh();
+    if (inventoryManager) {
+        connect(inventoryManager->changes(), &ChangeFeed::changed,
+                this, &ProductModel::applyChange);
+    }
 }
 
 ProductModel::~ProductModel() {
@@ -132,6 +138,8 @@ Qt::ItemFlags ProductModel::flags(const QModelIndex& index) const {
 void ProductModel::setProducts(const std::vector<Product>& newProducts) {
     beginResetModel();
     products = newProducts;
+    fixedList = true;
+    reindexFrom(0);
     endResetModel();
 }
 
@@ -142,28 +150,107 @@ Product ProductModel::getProduct(int row) const {
     return Product();
 }
 
+void ProductModel::setFilter(const QString& category, const QString& searchText) {
+    filterCategory = category;
+    filterText = searchText;
+    refresh();
+}
+
 void ProductModel::refresh() {
     if (inventoryManager) {
+        lastSequence = inventoryManager->changes()->lastSequence();
         beginResetModel();
-        auto productPtrs = inventoryManager->getAllProducts();
+        auto productPtrs = ProductFilterService::filterProducts(
+            *inventoryManager, filterCategory, filterText);
+        fixedList = false;
         products.clear();
         products.reserve(productPtrs.size());
         
-        int maxId = 0;
         for (const auto& productPtr : productPtrs) {
             if (productPtr) {
                 products.push_back(*productPtr);
-                if (productPtr->getId() > maxId) {
-                    maxId = productPtr->getId();
-                }
             }
         }
-        
-        if (maxId > 0) {
-            Product::setNextId(maxId);
-        }
+        reindexFrom(0);
         
         endResetModel();
     }
 }
 
+void ProductModel::applyChange(const ChangeEvent& event) {
+    if (event.sequence <= lastSequence) {
+        return;
+    }
+
+    // A gap in the sequence means a delta was missed; only a reload is safe.
+    bool inOrder = event.sequence == lastSequence + 1;
+    lastSequence = event.sequence;
+    if (!inOrder) {
+        refresh();
+        return;
+    }
+
+    int row = rowOf(event.id);
+    switch (event.kind) {
+        case ChangeEvent::Kind::ProductRemoved:
+            if (row >= 0) {
+                removeProductAt(row);
+            }
+            break;
+        case ChangeEvent::Kind::ProductUpserted:
+        case ChangeEvent::Kind::StockChanged: {
+            auto product = inventoryManager->getProduct(event.id);
+            if (!product) {
+                break;
+            }
+            if (row < 0) {
+                if (!fixedList && isShown(*product)) {
+                    appendProduct(*product);
+                }
+            } else if (fixedList || isShown(*product)) {
+                products[row] = *product;
+                emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+            } else {
+                removeProductAt(row);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+int ProductModel::rowOf(int id) const {
+    return rowsById.value(id, -1);
+}
+
+bool ProductModel::isShown(const Product& product) const {
+    return ProductFilterService::matches(product, filterCategory, filterText);
+}
+
+void ProductModel::appendProduct(const Product& product) {
+    int last = static_cast<int>(products.size());
+    beginInsertRows(QModelIndex(), last, last);
+    products.push_back(product);
+    rowsById.insert(product.getId(), last);
+    endInsertRows();
+}
+
+void ProductModel::removeProductAt(int row) {
+    beginRemoveRows(QModelIndex(), row, row);
+    rowsById.remove(products[row].getId());
+    products.erase(products.begin() + row);
+    reindexFrom(row);
+    endRemoveRows();
+}
+
+// Rows after a removal shift up, so their entries are rewritten.
+void ProductModel::reindexFrom(int row) {
+    if (row == 0) {
+        rowsById.clear();
+        rowsById.reserve(static_cast<qsizetype>(products.size()));
+    }
+    for (int i = row; i < static_cast<int>(products.size()); ++i) {
+        rowsById.insert(products[i].getId(), i);
+    }
+}
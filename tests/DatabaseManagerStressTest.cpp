@@ -0,0 +1,238 @@
+#include "entities/Order.h"
+#include "entities/OrderItem.h"
+#include "managers/DatabaseManager.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFuture>
+#include <QStandardPaths>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <set>
+#include <thread>
+#include <vector>
+
+// Hammers DatabaseManager from reader and writer threads, then checks that
+// every order and write-off written is stored exactly once under its id, in
+// memory and again after the data files are reopened.
+
+static const int WRITERS = 4;
+static const int READERS = 4;
+static const int ORDERS_PER_WRITER = 150;
+
+static std::atomic<int> failures(0);
+
+static void fail(const char *what, long long value) {
+  std::fprintf(stderr, "FAIL: %s (%lld)\n", what, value);
+  failures++;
+}
+
+static int quantityFor(int id) { return 1 + id % 7; }
+
+static Order makeOrder(int id, int writer) {
+  Order order(QString("Company %1").arg(writer), "Contact", "555-0100",
+              id % 2 ? OrderType::RETAIL : OrderType::WHOLESALE);
+  order.setId(id);
+  order.addItem(OrderItem(id, "Item", "Stress", quantityFor(id), 2.5));
+  return order;
+}
+
+// Half the orders go straight to the backend and half through the write
+// queue; every third order also records a queued write-off.
+static void writeOrders(DatabaseManager *db, int writer,
+                        std::vector<int> &written) {
+  std::vector<QFuture<bool>> pending;
+  for (int i = 0; i < ORDERS_PER_WRITER; ++i) {
+    int id = db->nextOrderId();
+    if (id <= 0) {
+      fail("nextOrderId", id);
+      continue;
+    }
+    written.push_back(id);
+
+    Order order = makeOrder(id, writer);
+    if (i % 2) {
+      pending.push_back(db->addOrderAsync(order));
+    } else if (!db->addOrder(order)) {
+      fail("addOrder", id);
+    }
+
+    if (i % 3 == 0) {
+      pending.push_back(
+          db->addWriteOffRecordAsync(id, 1, 1.0, "stress", "Item"));
+    } else if (!db->addWriteOffRecord(id, 1, 1.0, "stress", "Item")) {
+      fail("addWriteOffRecord", id);
+    }
+  }
+
+  for (auto &future : pending) {
+    future.waitForFinished();
+    if (!future.result()) {
+      fail("queued write", writer);
+    }
+  }
+}
+
+// Only adds happen, so every read must list distinct ids in ascending order
+// and never fewer records than the read before it.
+static void readOrders(DatabaseManager *db, const std::atomic<bool> &done) {
+  size_t lastHeaders = 0;
+  size_t lastWriteOffs = 0;
+  while (!done) {
+    std::vector<OrderHeader> headers = db->getOrderHeaders();
+    int previous = 0;
+    for (const auto &header : headers) {
+      if (header.id <= previous) {
+        fail("order headers not in ascending id order", header.id);
+      }
+      previous = header.id;
+    }
+    if (headers.size() < lastHeaders) {
+      fail("order count went down", static_cast<long long>(headers.size()));
+    }
+    lastHeaders = headers.size();
+
+    if (!headers.empty()) {
+      int id = headers[headers.size() / 2].id;
+      Order order = db->getOrder(id);
+      if (order.getId() != id || order.getItems().size() != 1 ||
+          order.getItems().front().quantity != quantityFor(id)) {
+        fail("getOrder", id);
+      }
+    }
+
+    size_t writeOffs = db->getWriteOffHistory().size();
+    if (writeOffs < lastWriteOffs) {
+      fail("write-off count went down", static_cast<long long>(writeOffs));
+    }
+    lastWriteOffs = writeOffs;
+
+    db->getTotalProductQuantity();
+  }
+}
+
+// Two forEachOrder visits must be inside the orders store at once: each
+// visitor waits on its first order until the other visit has arrived.
+static void checkReadersOverlap(DatabaseManager *db) {
+  std::atomic<int> inside(0);
+  std::atomic<bool> timedOut(false);
+  auto visit = [&] {
+    bool arrived = false;
+    db->forEachOrder([&](const Order &) {
+      if (arrived) {
+        return;
+      }
+      arrived = true;
+      inside++;
+      auto deadline =
+          std::chrono::steady_clock::now() + std::chrono::seconds(5);
+      while (inside < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+      }
+      if (inside < 2) {
+        timedOut = true;
+      }
+    });
+  };
+
+  std::thread first(visit);
+  std::thread second(visit);
+  first.join();
+  second.join();
+  if (timedOut || inside != 2) {
+    fail("readers did not overlap", inside.load());
+  }
+}
+
+static void checkStored(DatabaseManager *db, const std::set<int> &expected,
+                        const char *stage) {
+  std::vector<Order> orders = db->getAllOrders();
+  std::set<int> stored;
+  for (const auto &order : orders) {
+    if (!stored.insert(order.getId()).second) {
+      fail("duplicate stored order", order.getId());
+    }
+    if (order.getItems().size() != 1 ||
+        order.getItems().front().quantity != quantityFor(order.getId())) {
+      fail("stored order contents", order.getId());
+    }
+  }
+  if (stored != expected) {
+    std::fprintf(stderr, "%s: %zu orders stored, %zu expected\n", stage,
+                 stored.size(), expected.size());
+    fail("stored order ids", static_cast<long long>(stored.size()));
+  }
+
+  size_t writeOffs = db->getWriteOffHistory().size();
+  if (writeOffs != expected.size()) {
+    fail("stored write-off count", static_cast<long long>(writeOffs));
+  }
+}
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QStandardPaths::setTestModeEnabled(true);
+  app.setApplicationName("DatabaseManagerStressTest");
+  QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation))
+      .removeRecursively();
+
+  DatabaseManager *db = DatabaseManager::getInstance();
+  if (!db->connect()) {
+    std::fprintf(stderr, "FAIL: connect\n");
+    return 1;
+  }
+
+  // One round reads from disk, the next from the resident caches.
+  std::set<int> expected;
+  for (bool resident : {false, true}) {
+    db->setResidentCacheEnabled(resident);
+
+    std::atomic<bool> done(false);
+    std::vector<std::vector<int>> written(WRITERS);
+    std::vector<std::thread> readers;
+    std::vector<std::thread> writers;
+    for (int i = 0; i < READERS; ++i) {
+      readers.emplace_back(readOrders, db, std::cref(done));
+    }
+    for (int i = 0; i < WRITERS; ++i) {
+      writers.emplace_back(writeOrders, db, i, std::ref(written[i]));
+    }
+    for (auto &writer : writers) {
+      writer.join();
+    }
+    done = true;
+    for (auto &reader : readers) {
+      reader.join();
+    }
+
+    for (const auto &ids : written) {
+      for (int id : ids) {
+        if (!expected.insert(id).second) {
+          fail("id handed out twice", id);
+        }
+      }
+    }
+    if (!db->flush()) {
+      fail("flush", resident);
+    }
+    checkStored(db, expected, resident ? "resident" : "on disk");
+    checkReadersOverlap(db);
+  }
+
+  DatabaseManager::destroyInstance();
+  db = DatabaseManager::getInstance();
+  if (!db->connect()) {
+    fail("reconnect", 0);
+  } else {
+    checkStored(db, expected, "reopened");
+  }
+  DatabaseManager::destroyInstance();
+
+  if (failures > 0) {
+    std::fprintf(stderr, "%d failures\n", failures.load());
+    return 1;
+  }
+  std::printf("%zu orders from %d writers and %d readers\n", expected.size(),
+              WRITERS, READERS);
+  return 0;
+}